@@ -3,8 +3,7 @@
 
 uniform mat4 model;
 uniform mat4 view_projection;
-uniform mat4 pose[100];
-uniform mat4 invBindPose[100];
+uniform mat4 palette[100]; // skin matrices: pose * inverse bind pose of each joint
 
 uniform sampler2D morphTargetsTexture;
 uniform ivec2 morphTargetsTextureSize;
@@ -46,10 +45,10 @@ void main()
     }
 
 	// Compute skinning
-	mat4 skin = (pose[joints.x] * invBindPose[joints.x]) * weights.x;
-    skin += (pose[joints.y] * invBindPose[joints.y]) * weights.y;
-    skin += (pose[joints.z] * invBindPose[joints.z]) * weights.z;
-    skin += (pose[joints.w] * invBindPose[joints.w]) * weights.w;
+	mat4 skin = palette[joints.x] * weights.x;
+    skin += palette[joints.y] * weights.y;
+    skin += palette[joints.z] * weights.z;
+    skin += palette[joints.w] * weights.w;
 
 	// Transform the final computed vertex position into clip space
     gl_Position = view_projection * model * skin * vec4(transformed,1.0);
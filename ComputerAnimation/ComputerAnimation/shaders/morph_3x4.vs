@@ -0,0 +1,63 @@
+#version 330 core
+#define MORPHTARGETS_COUNT 50
+
+uniform mat4 model;
+uniform mat4 view_projection;
+uniform mat3x4 palette[100]; // skin matrices (pose * inverse bind pose) without their last row: each column is a row of the matrix
+
+uniform sampler2D morphTargetsTexture;
+uniform ivec2 morphTargetsTextureSize;
+
+uniform int numMorphTargets;
+uniform float morphTargetInfluences[ MORPHTARGETS_COUNT ];
+uniform int numVertices;
+
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+in vec4 weights;
+in ivec4 joints;
+
+out vec3 norm;
+out vec3 fragPos;
+out vec2 uv;
+
+// [CA] To do: Create a function to get the vertex position offset given the index of the vertex and the index of the morph target
+vec4 getMorph( const int vertexIndex, const int morphTargetIndex ) 
+{
+	ivec2 texCoord = ivec2(vertexIndex, morphTargetIndex);
+
+    // read the texture using the computed x and y coordinates
+	vec4 offset = texelFetch(morphTargetsTexture, texCoord, 0); 
+	return offset;
+}
+
+void main() 
+{
+
+	vec3 transformed = vec3( position );
+
+	// [CA] To do: For each morph target, accumulate the offset position taking into account its influence
+	for (int i = 0; i < numMorphTargets; i++) 
+	{
+        vec4 offset = getMorph(gl_VertexID, i) * morphTargetInfluences[i];
+        transformed = transformed + offset.xyz;
+    }
+
+	// Compute skinning
+	mat3x4 skin = palette[joints.x] * weights.x;
+    skin += palette[joints.y] * weights.y;
+    skin += palette[joints.z] * weights.z;
+    skin += palette[joints.w] * weights.w;
+
+	// row vector * mat3x4 = the rows of the skin matrix by the vector
+	vec3 skinnedPosition = vec4(transformed, 1.0) * skin;
+	vec3 skinnedNormal = vec4(normal, 0.0) * skin;
+
+	// Transform the final computed vertex position into clip space
+    gl_Position = view_projection * model * vec4(skinnedPosition, 1.0);
+    fragPos = vec3(model * vec4(skinnedPosition, 1.0));
+    norm = vec3(model * vec4(skinnedNormal, 0.0f));
+    uv = texCoord;
+   
+}
\ No newline at end of file
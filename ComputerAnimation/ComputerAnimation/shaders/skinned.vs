@@ -2,8 +2,7 @@
 
 uniform mat4 model;
 uniform mat4 view_projection;
-uniform mat4 pose[120];
-uniform mat4 invBindPose[120];
+uniform mat4 palette[120]; // skin matrices: pose * inverse bind pose of each joint
 
 in vec3 position;
 in vec3 normal;
@@ -16,10 +15,10 @@ out vec3 fragPos;
 out vec2 uv;
 
 void main() {
-    mat4 skin = (pose[joints.x] * invBindPose[joints.x]) * weights.x;
-    skin += (pose[joints.y] * invBindPose[joints.y]) * weights.y;
-    skin += (pose[joints.z] * invBindPose[joints.z]) * weights.z;
-    skin += (pose[joints.w] * invBindPose[joints.w]) * weights.w;
+    mat4 skin = palette[joints.x] * weights.x;
+    skin += palette[joints.y] * weights.y;
+    skin += palette[joints.z] * weights.z;
+    skin += palette[joints.w] * weights.w;
     gl_Position = view_projection * model * skin * vec4(position,1.0);
     fragPos = vec3(model * skin * vec4(position, 1.0));
     norm = vec3(model * skin * vec4(normal, 0.0f));
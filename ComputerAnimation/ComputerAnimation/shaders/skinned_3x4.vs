@@ -0,0 +1,29 @@
+#version 450 core
+
+uniform mat4 model;
+uniform mat4 view_projection;
+uniform mat3x4 palette[120]; // skin matrices (pose * inverse bind pose) without their last row: each column is a row of the matrix
+
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+in vec4 weights;
+in ivec4 joints;
+
+out vec3 norm;
+out vec3 fragPos;
+out vec2 uv;
+
+void main() {
+    mat3x4 skin = palette[joints.x] * weights.x;
+    skin += palette[joints.y] * weights.y;
+    skin += palette[joints.z] * weights.z;
+    skin += palette[joints.w] * weights.w;
+    // row vector * mat3x4 = the rows of the skin matrix by the vector
+    vec3 skinnedPosition = vec4(position, 1.0) * skin;
+    vec3 skinnedNormal = vec4(normal, 0.0) * skin;
+    gl_Position = view_projection * model * vec4(skinnedPosition, 1.0);
+    fragPos = vec3(model * vec4(skinnedPosition, 1.0));
+    norm = vec3(model * vec4(skinnedNormal, 0.0f));
+    uv = texCoord;
+}
@@ -0,0 +1,45 @@
+#version 450 core
+
+uniform mat4 model;
+uniform mat4 view_projection;
+uniform mat2x4 dqPalette[120]; // skin transforms as dual quaternions: rotation (xyzw) in the first column, dual part in the second
+
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+in vec4 weights;
+in ivec4 joints;
+
+out vec3 norm;
+out vec3 fragPos;
+out vec2 uv;
+
+// rotation of a vector by a unit quaternion
+vec3 rotate(vec4 q, vec3 v) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    // blend the dual quaternions of the joints, flipping the ones in the opposite hemisphere of the first one
+    mat2x4 dq0 = dqPalette[joints.x];
+    mat2x4 dq1 = dqPalette[joints.y];
+    mat2x4 dq2 = dqPalette[joints.z];
+    mat2x4 dq3 = dqPalette[joints.w];
+    float w1 = dot(dq0[0], dq1[0]) < 0.0 ? -weights.y : weights.y;
+    float w2 = dot(dq0[0], dq2[0]) < 0.0 ? -weights.z : weights.z;
+    float w3 = dot(dq0[0], dq3[0]) < 0.0 ? -weights.w : weights.w;
+    mat2x4 dq = dq0 * weights.x + dq1 * w1 + dq2 * w2 + dq3 * w3;
+    dq /= length(dq[0]);
+
+    vec4 real = dq[0];
+    vec4 dual = dq[1];
+    // translation = 2 * dual * conjugate(real)
+    vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+    vec3 skinnedPosition = rotate(real, position) + translation;
+    vec3 skinnedNormal = rotate(real, normal);
+
+    gl_Position = view_projection * model * vec4(skinnedPosition, 1.0);
+    fragPos = vec3(model * vec4(skinnedPosition, 1.0));
+    norm = vec3(model * vec4(skinnedNormal, 0.0f));
+    uv = texCoord;
+}
@@ -1,31 +1,351 @@
 #include "clip.h"
+#include <iostream>
+#include <chrono>
+#include <emmintrin.h>
 
-Clip::Clip() {
+template TClip<TransformTrack>;
+template TClip<FastTransformTrack>;
+
+// SSE kernels of the batched sampling: the keys of 4 component tracks are loaded in SoA (one register per component),
+// and the operations are the same as the scalar lerp and nlerp of the tracks, so the results match them
+namespace ClipHelpers {
+
+	// up to 4 keys waiting to be interpolated, the keys of a batch have 3 (vec3) or 4 (quat) components
+	struct Batch {
+		const float* from[4];
+		const float* to[4];
+		float t[4];
+		float* out[4]; // where the interpolated values are written
+		int components;
+		int count;
+
+		inline Batch(int numComponents) : components(numComponents), count(0) { }
+	};
+
+	// normalizes 4 quaternions, the ones too short to be normalized become the identity (like normalized())
+	inline void normalize(__m128& x, __m128& y, __m128& z, __m128& w) {
+		__m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+		__m128 valid = _mm_cmpge_ps(lenSq, _mm_set1_ps(QUAT_EPSILON));
+		__m128 il = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lenSq));
+		x = _mm_and_ps(valid, _mm_mul_ps(x, il));
+		y = _mm_and_ps(valid, _mm_mul_ps(y, il));
+		z = _mm_and_ps(valid, _mm_mul_ps(z, il));
+		w = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(w, il)), _mm_andnot_ps(valid, _mm_set1_ps(1.0f)));
+	}
+
+	// lerp of vec3
+	inline void lerpVectors(Batch& batch) {
+		__m128 t = _mm_loadu_ps(batch.t);
+		float result[3][4];
+		for (int c = 0; c < 3; ++c) {
+			__m128 a = _mm_set_ps(batch.from[3][c], batch.from[2][c], batch.from[1][c], batch.from[0][c]);
+			__m128 b = _mm_set_ps(batch.to[3][c], batch.to[2][c], batch.to[1][c], batch.to[0][c]);
+			_mm_storeu_ps(result[c], _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+		}
+		for (int i = 0; i < batch.count; ++i) {
+			batch.out[i][0] = result[0][i];
+			batch.out[i][1] = result[1][i];
+			batch.out[i][2] = result[2][i];
+		}
+	}
+
+	// nlerp of quaternions in the same neighborhood, the keys are normalized first (like Track::cast)
+	inline void nlerpQuaternions(Batch& batch) {
+		__m128 ax = _mm_loadu_ps(batch.from[0]);
+		__m128 ay = _mm_loadu_ps(batch.from[1]);
+		__m128 az = _mm_loadu_ps(batch.from[2]);
+		__m128 aw = _mm_loadu_ps(batch.from[3]);
+		_MM_TRANSPOSE4_PS(ax, ay, az, aw);
+		__m128 bx = _mm_loadu_ps(batch.to[0]);
+		__m128 by = _mm_loadu_ps(batch.to[1]);
+		__m128 bz = _mm_loadu_ps(batch.to[2]);
+		__m128 bw = _mm_loadu_ps(batch.to[3]);
+		_MM_TRANSPOSE4_PS(bx, by, bz, bw);
+		normalize(ax, ay, az, aw);
+		normalize(bx, by, bz, bw);
+
+		// neighborhood: flip the sign of the second key if the dot product is negative
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+		__m128 sign = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+		bx = _mm_xor_ps(bx, sign);
+		by = _mm_xor_ps(by, sign);
+		bz = _mm_xor_ps(bz, sign);
+		bw = _mm_xor_ps(bw, sign);
+
+		// mix: from * (1 - t) + to * t
+		__m128 t = _mm_loadu_ps(batch.t);
+		__m128 s = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+		__m128 x = _mm_add_ps(_mm_mul_ps(ax, s), _mm_mul_ps(bx, t));
+		__m128 y = _mm_add_ps(_mm_mul_ps(ay, s), _mm_mul_ps(by, t));
+		__m128 z = _mm_add_ps(_mm_mul_ps(az, s), _mm_mul_ps(bz, t));
+		__m128 w = _mm_add_ps(_mm_mul_ps(aw, s), _mm_mul_ps(bw, t));
+		normalize(x, y, z, w);
+
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		float result[4][4];
+		_mm_storeu_ps(result[0], x);
+		_mm_storeu_ps(result[1], y);
+		_mm_storeu_ps(result[2], z);
+		_mm_storeu_ps(result[3], w);
+		for (int i = 0; i < batch.count; ++i) {
+			for (int c = 0; c < 4; ++c) {
+				batch.out[i][c] = result[i][c];
+			}
+		}
+	}
+
+	// interpolates the keys of the batch and empties it
+	inline void flush(Batch& batch) {
+		if (batch.count == 0) {
+			return;
+		}
+		// unused lanes repeat the first key
+		for (int i = batch.count; i < 4; ++i) {
+			batch.from[i] = batch.from[0];
+			batch.to[i] = batch.to[0];
+			batch.t[i] = batch.t[0];
+		}
+		if (batch.components == 3) {
+			lerpVectors(batch);
+		}
+		else {
+			nlerpQuaternions(batch);
+		}
+		batch.count = 0;
+	}
+
+	// adds the keys of the track at the given time to the batch, the result will be written in out.
+	// The segment of tracks that share a timeline has already been found.
+	template<typename T, int N>
+	inline void addKeys(Batch& batch, Track<T, N>& track, float time, bool looping, TrackCursor* cursor, T& out,
+		int timeline, const std::vector<int>& segmentFrames, const std::vector<float>& segmentTimes) {
+		float t = 0.0f;
+		int frame;
+		if (timeline >= 0) {
+			frame = segmentFrames[timeline];
+			t = segmentTimes[timeline];
+		}
+		else {
+			frame = track.findSegment(time, looping, t, cursor);
+		}
+		if (frame < 0) {
+			out = T(); // same as the scalar sample
+			return;
+		}
+		const float* values = track.getValues();
+		batch.from[batch.count] = &values[frame * N];
+		batch.to[batch.count] = &values[(frame + 1) * N];
+		batch.t[batch.count] = t;
+		batch.out[batch.count] = &out.v[0];
+		if (++batch.count == 4) {
+			flush(batch);
+		}
+	}
+
+	// samples a component track with the interpolation of the policy, like addKeys for the other interpolations
+	template<typename POLICY, typename T, int N>
+	inline T sampleComponent(Track<T, N>& track, float time, bool looping, TrackCursor* cursor,
+		int timeline, const std::vector<int>& segmentFrames, const std::vector<float>& segmentTimes) {
+		if (timeline < 0) {
+			return track.template sample<POLICY>(time, looping, cursor);
+		}
+		int frame = segmentFrames[timeline];
+		if (frame < 0) {
+			return T(); // same as the sample of the track
+		}
+		return POLICY::sampleSegment(track, frame, segmentTimes[timeline]);
+	}
+
+	// index of the timeline with the times of the track, a new timeline is added if none matches.
+	// Constant tracks keep searching their own frames.
+	template<typename T, int N>
+	inline int findTimeline(Track<T, N>& track, std::vector<Timeline>& timelines) {
+		unsigned int size = track.size();
+		if (size <= 1 || track.getInterpolation() == Interpolation::Constant) {
+			return -1;
+		}
+		const float* times = track.getTimes();
+		for (unsigned int i = 0, numTimelines = (unsigned int)timelines.size(); i < numTimelines; ++i) {
+			if (timelines[i].matches(times, size)) {
+				track.shareTimes(timelines[i].getTimes()); // the private copy of the times is released
+				return (int)i;
+			}
+		}
+		timelines.push_back(Timeline(track.getSharedTimes()));
+		return (int)timelines.size() - 1;
+	}
+
+	// the timelines of a FastClip search the frames with the lookup table of its tracks
+	inline bool usesLookupTable(TransformTrack*) { return false; }
+	inline bool usesLookupTable(FastTransformTrack*) { return true; }
+}; // End Clip helpers namespace
+
+template <typename TRACK>
+TClip<TRACK>::TClip() {
 	name = "No name given";
 	startTime = 0.0f;
 	endTime = 0.0f;
 	looping = true;
+	grouped = false;
+	shareTimes = false;
 }
 
-float Clip::sample(Pose& outPose, float time) {
+template <typename TRACK>
+float TClip<TRACK>::sample(Pose& outPose, float time, ClipCursor* cursor) {
 	if (getDuration() == 0.0f) {
 		return 0.0f;
 	}
 	time = adjustTimeToFitRange(time);
 	unsigned int size = tracks.size();
-	for (unsigned int i = 0; i < size; ++i) {
-		// get the joint ID of the  track
-		unsigned int j = tracks[i].getId(); // Joint
-		Transform local = outPose.getLocalTransform(j);
-		// sample the track
-		Transform animated = tracks[i].sample(local, time, looping);
-		// assign the sampled value back to the Pose reference
-		outPose.setLocalTransform(j, animated);
+	if (!grouped) {
+		groupTracks();
+	}
+	if (cursor != 0 && (cursor->size() != size || cursor->getNumTimelines() != timelines.size())) {
+		cursor->resize(size, (unsigned int)timelines.size());
 	}
+	if (!timelines.empty()) {
+		findSegments(time, cursor);
+	}
+	// components that aren't animated keep the value of the pose
+	sampleGroups<ConstantInterpolation>(outPose, time, cursor);
+	sampleLinearGroups(outPose, time, cursor);
+	sampleGroups<CubicInterpolation>(outPose, time, cursor);
 	return time;
 }
 
-float Clip::adjustTimeToFitRange(float inTime) {
+// samples the component tracks of the groups of an interpolation type, the interpolation is known at compile time
+template <typename TRACK>
+template <typename POLICY>
+void TClip<TRACK>::sampleGroups(Pose& outPose, float time, ClipCursor* cursor) {
+	int group = (int)POLICY::type;
+	std::vector<unsigned int>& positions = positionGroups[group];
+	for (unsigned int i = 0, size = (unsigned int)positions.size(); i < size; ++i) {
+		TRACK& track = tracks[positions[i]];
+		unsigned int j = track.getId(); // Joint
+		Transform local = outPose.getLocalTransform(j);
+		local.position = ClipHelpers::sampleComponent<POLICY>(track.getPositionTrack(), time, looping, cursor ? &cursor->getTrackCursors(positions[i])[0] : 0,
+			getTimeline(positions[i], 0), segmentFrames, segmentTimes);
+		outPose.setLocalTransform(j, local);
+	}
+	std::vector<unsigned int>& rotations = rotationGroups[group];
+	for (unsigned int i = 0, size = (unsigned int)rotations.size(); i < size; ++i) {
+		TRACK& track = tracks[rotations[i]];
+		unsigned int j = track.getId();
+		Transform local = outPose.getLocalTransform(j);
+		local.rotation = ClipHelpers::sampleComponent<POLICY>(track.getRotationTrack(), time, looping, cursor ? &cursor->getTrackCursors(rotations[i])[1] : 0,
+			getTimeline(rotations[i], 1), segmentFrames, segmentTimes);
+		outPose.setLocalTransform(j, local);
+	}
+	std::vector<unsigned int>& scales = scaleGroups[group];
+	for (unsigned int i = 0, size = (unsigned int)scales.size(); i < size; ++i) {
+		TRACK& track = tracks[scales[i]];
+		unsigned int j = track.getId();
+		Transform local = outPose.getLocalTransform(j);
+		local.scale = ClipHelpers::sampleComponent<POLICY>(track.getScaleTrack(), time, looping, cursor ? &cursor->getTrackCursors(scales[i])[2] : 0,
+			getTimeline(scales[i], 2), segmentFrames, segmentTimes);
+		outPose.setLocalTransform(j, local);
+	}
+}
+
+template <typename TRACK>
+void TClip<TRACK>::sampleLinearGroups(Pose& outPose, float time, ClipCursor* cursor) {
+	int group = (int)Interpolation::Linear;
+	Transform* locals = outPose.getLocalTransforms();
+	ClipHelpers::Batch vectors(3);
+	ClipHelpers::Batch rotations(4);
+	std::vector<unsigned int>& positions = positionGroups[group];
+	for (unsigned int i = 0, size = (unsigned int)positions.size(); i < size; ++i) {
+		TRACK& track = tracks[positions[i]];
+		ClipHelpers::addKeys(vectors, track.getPositionTrack(), time, looping,
+			cursor ? &cursor->getTrackCursors(positions[i])[0] : 0, locals[track.getId()].position,
+			getTimeline(positions[i], 0), segmentFrames, segmentTimes);
+	}
+	std::vector<unsigned int>& scales = scaleGroups[group];
+	for (unsigned int i = 0, size = (unsigned int)scales.size(); i < size; ++i) {
+		TRACK& track = tracks[scales[i]];
+		ClipHelpers::addKeys(vectors, track.getScaleTrack(), time, looping,
+			cursor ? &cursor->getTrackCursors(scales[i])[2] : 0, locals[track.getId()].scale,
+			getTimeline(scales[i], 2), segmentFrames, segmentTimes);
+	}
+	ClipHelpers::flush(vectors);
+	std::vector<unsigned int>& rotationTracks = rotationGroups[group];
+	for (unsigned int i = 0, size = (unsigned int)rotationTracks.size(); i < size; ++i) {
+		TRACK& track = tracks[rotationTracks[i]];
+		ClipHelpers::addKeys(rotations, track.getRotationTrack(), time, looping,
+			cursor ? &cursor->getTrackCursors(rotationTracks[i])[1] : 0, locals[track.getId()].rotation,
+			getTimeline(rotationTracks[i], 1), segmentFrames, segmentTimes);
+	}
+	ClipHelpers::flush(rotations);
+}
+
+// a component is only sampled if its track has frames (like TransformTrack::sample),
+// constant channels (a single frame) are sampled with the constant interpolation
+template <typename TRACK>
+void TClip<TRACK>::groupTracks() {
+	for (int i = 0; i < 3; ++i) {
+		positionGroups[i].clear();
+		rotationGroups[i].clear();
+		scaleGroups[i].clear();
+	}
+	int constant = (int)Interpolation::Constant;
+	for (unsigned int i = 0, size = (unsigned int)tracks.size(); i < size; ++i) {
+		unsigned int positionFrames = tracks[i].getPositionTrack().size();
+		if (positionFrames > 0) {
+			positionGroups[positionFrames == 1 ? constant : (int)tracks[i].getPositionTrack().getInterpolation()].push_back(i);
+		}
+		unsigned int rotationFrames = tracks[i].getRotationTrack().size();
+		if (rotationFrames > 0) {
+			rotationGroups[rotationFrames == 1 ? constant : (int)tracks[i].getRotationTrack().getInterpolation()].push_back(i);
+		}
+		unsigned int scaleFrames = tracks[i].getScaleTrack().size();
+		if (scaleFrames > 0) {
+			scaleGroups[scaleFrames == 1 ? constant : (int)tracks[i].getScaleTrack().getInterpolation()].push_back(i);
+		}
+	}
+	buildTimelines();
+	grouped = true;
+}
+
+template <typename TRACK>
+void TClip<TRACK>::buildTimelines() {
+	timelines.clear();
+	timelineIndices.clear();
+	if (!shareTimes) {
+		return;
+	}
+	timelineIndices.resize(tracks.size() * 3);
+	for (unsigned int i = 0, size = (unsigned int)tracks.size(); i < size; ++i) {
+		timelineIndices[i * 3] = ClipHelpers::findTimeline(tracks[i].getPositionTrack(), timelines);
+		timelineIndices[i * 3 + 1] = ClipHelpers::findTimeline(tracks[i].getRotationTrack(), timelines);
+		timelineIndices[i * 3 + 2] = ClipHelpers::findTimeline(tracks[i].getScaleTrack(), timelines);
+	}
+	if (ClipHelpers::usesLookupTable((TRACK*)0)) {
+		for (unsigned int i = 0, size = (unsigned int)timelines.size(); i < size; ++i) {
+			timelines[i].updateIndexLookupTable();
+		}
+	}
+	segmentFrames.resize(timelines.size());
+	segmentTimes.resize(timelines.size());
+}
+
+template <typename TRACK>
+void TClip<TRACK>::findSegments(float time, ClipCursor* cursor) {
+	for (unsigned int i = 0, size = (unsigned int)timelines.size(); i < size; ++i) {
+		float t = 0.0f;
+		segmentFrames[i] = timelines[i].findSegment(time, looping, t, cursor ? cursor->getTimelineCursor(i) : 0);
+		segmentTimes[i] = t;
+	}
+}
+
+template <typename TRACK>
+void TClip<TRACK>::shareTimelines() {
+	shareTimes = true;
+	grouped = false;
+	buildTimelines(); // the tracks release their copies of the times now instead of at the first sample
+}
+
+template <typename TRACK>
+float TClip<TRACK>::adjustTimeToFitRange(float inTime) {
 	if (looping) {
 		float duration = endTime - startTime;
 		if (duration <= 0) { 0.0f; }
@@ -46,7 +366,8 @@ float Clip::adjustTimeToFitRange(float inTime) {
 	return inTime;
 }
 
-void Clip::recalculateDuration() {
+template <typename TRACK>
+void TClip<TRACK>::recalculateDuration() {
 	startTime = 0.0f;
 	endTime = 0.0f;
 	bool startSet = false;
@@ -69,56 +390,388 @@ void Clip::recalculateDuration() {
 }
 
 // retrieves the TransformTrack object for a specific joint in the clip
-TransformTrack& Clip::operator[](unsigned int joint) {
-	for (int i = 0, s = tracks.size(); i < s; ++i) {
-		if (tracks[i].getId() == joint) {
-			return tracks[i];
-		}
+template <typename TRACK>
+TRACK& TClip<TRACK>::operator[](unsigned int joint) {
+	grouped = false; // the caller may change the frames or the interpolation of the track
+	TRACK* track = findTrack(joint);
+	if (track != 0) {
+		return *track;
 	}
 	// if no qualifying track is found, a new one is created and returned
-	tracks.push_back(TransformTrack());
+	tracks.push_back(TRACK());
 	tracks[tracks.size() - 1].setId(joint);
+	setTrackIndex(joint, (int)tracks.size() - 1);
 	return tracks[tracks.size() - 1];
 }
 
+template <typename TRACK>
+TRACK* TClip<TRACK>::findTrack(unsigned int joint) {
+	if (joint >= trackIndices.size() || trackIndices[joint] < 0) {
+		return 0;
+	}
+	return &tracks[trackIndices[joint]];
+}
+
+template <typename TRACK>
+const TRACK* TClip<TRACK>::findTrack(unsigned int joint) const {
+	if (joint >= trackIndices.size() || trackIndices[joint] < 0) {
+		return 0;
+	}
+	return &tracks[trackIndices[joint]];
+}
+
+// the table grows with the highest joint id of the clip
+template <typename TRACK>
+void TClip<TRACK>::setTrackIndex(unsigned int joint, int index) {
+	if (joint >= trackIndices.size()) {
+		trackIndices.resize(joint + 1, -1);
+	}
+	trackIndices[joint] = index;
+}
+
 // getters
-std::string& Clip::getName() {
+template <typename TRACK>
+std::string& TClip<TRACK>::getName() {
 	return name;
 }
 
-unsigned int Clip::getIdAtIndex(unsigned int index) {
+template <typename TRACK>
+unsigned int TClip<TRACK>::getIdAtIndex(unsigned int index) {
 	return tracks[index].getId();
 }
 
-unsigned int Clip::size() {
+template <typename TRACK>
+unsigned int TClip<TRACK>::size() {
 	return (unsigned int)tracks.size();
 }
 
-float Clip::getDuration() {
+template <typename TRACK>
+float TClip<TRACK>::getDuration() {
 	return endTime - startTime;
 }
 
-float Clip::getStartTime() {
+template <typename TRACK>
+float TClip<TRACK>::getStartTime() {
 	return startTime;
 }
 
-float Clip::getEndTime() {
+template <typename TRACK>
+float TClip<TRACK>::getEndTime() {
 	return endTime;
 }
 
-bool Clip::getLooping() {
+template <typename TRACK>
+bool TClip<TRACK>::getLooping() {
 	return looping;
 }
 
+template <typename TRACK>
+bool TClip<TRACK>::getShareTimelines() {
+	return shareTimes;
+}
+
+template <typename TRACK>
+unsigned int TClip<TRACK>::getNumTimelines() {
+	if (!grouped) {
+		groupTracks();
+	}
+	return (unsigned int)timelines.size();
+}
+
 // setters
-void Clip::setName(const std::string& inNewName) {
+template <typename TRACK>
+void TClip<TRACK>::setName(const std::string& inNewName) {
 	name = inNewName;
 }
 
-void Clip::setIdAtIndex(unsigned int index, unsigned int id) {
-	return tracks[index].setId(id);
+template <typename TRACK>
+void TClip<TRACK>::setIdAtIndex(unsigned int index, unsigned int id) {
+	unsigned int oldId = tracks[index].getId();
+	if (oldId < trackIndices.size() && trackIndices[oldId] == (int)index) {
+		trackIndices[oldId] = -1;
+	}
+	tracks[index].setId(id);
+	setTrackIndex(id, (int)index);
 }
 
-void Clip::setLooping(bool inLooping) {
+template <typename TRACK>
+void TClip<TRACK>::setLooping(bool inLooping) {
 	looping = inLooping;
+}
+
+FastClip optimizeClip(Clip& input) {
+	FastClip result;
+	result.setName(input.getName());
+	result.setLooping(input.getLooping());
+	unsigned int size = input.size();
+	for (unsigned int i = 0; i < size; ++i) {
+		unsigned int joint = input.getIdAtIndex(i);
+		FastTransformTrack& track = result[joint];
+		track = optimizeTransformTrack(*input.findTrack(joint));
+	}
+	if (input.getShareTimelines()) {
+		result.shareTimelines();
+	}
+	result.recalculateDuration();
+	return result;
+}
+
+// constant channel elimination
+namespace ClipHelpers {
+
+	inline bool equal(const vec3& a, const vec3& b, float tolerance) {
+		return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+	}
+	inline bool equal(const quat& a, const quat& _b, float tolerance) {
+		quat b = dot(a, _b) < 0.0f ? -_b : _b; // q and -q are the same rotation
+		return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance && fabsf(a.w - b.w) <= tolerance;
+	}
+
+	// collapses the track if it's constant, and empties it if its value is the one of the rest pose
+	template<typename T, int N>
+	inline void removeConstantChannel(Track<T, N>& track, const T& rest, float tolerance, ConstantChannelsReport& report) {
+		if (!track.isConstant(tolerance)) {
+			return;
+		}
+		unsigned int bytes = track.getByteSize();
+		if (track.size() > 1) {
+			++report.interpolationsSaved; // the constant channel doesn't search and interpolate frames
+		}
+		track.collapse();
+		if (equal(track.sample(0.0f, false), rest, tolerance)) {
+			track = Track<T, N>();
+			++report.removed;
+		}
+		else {
+			++report.collapsed;
+		}
+		report.bytesSaved += bytes - track.getByteSize();
+	}
+}; // End Clip helpers namespace
+
+ConstantChannelsReport removeConstantChannels(Clip& clip, Pose& restPose, float tolerance) {
+	ConstantChannelsReport report;
+	for (unsigned int i = 0, size = clip.size(); i < size; ++i) {
+		unsigned int joint = clip.getIdAtIndex(i);
+		TransformTrack& track = clip[joint];
+		Transform rest = restPose.getLocalTransform(joint);
+		ClipHelpers::removeConstantChannel(track.getPositionTrack(), rest.position, tolerance, report);
+		ClipHelpers::removeConstantChannel(track.getRotationTrack(), rest.rotation, tolerance, report);
+		ClipHelpers::removeConstantChannel(track.getScaleTrack(), rest.scale, tolerance, report);
+	}
+	return report;
+}
+
+KeyReductionReport reduceKeys(Clip& clip, const KeyReductionOptions& options) {
+	KeyReductionReport report;
+	for (unsigned int i = 0, size = clip.size(); i < size; ++i) {
+		TransformTrack& track = clip[clip.getIdAtIndex(i)];
+		VectorTrack& position = track.getPositionTrack();
+		QuaternionTrack& rotation = track.getRotationTrack();
+		VectorTrack& scale = track.getScaleTrack();
+		report.keysBefore += position.size() + rotation.size() + scale.size();
+		report.maxPositionError = fmaxf(report.maxPositionError, position.reduceKeys(options.positionTolerance));
+		report.maxRotationError = fmaxf(report.maxRotationError, rotation.reduceKeys(options.rotationTolerance));
+		report.maxScaleError = fmaxf(report.maxScaleError, scale.reduceKeys(options.scaleTolerance));
+		report.keysAfter += position.size() + rotation.size() + scale.size();
+	}
+	return report;
+}
+
+void printConstantChannelsReport(const std::string& clipName, const ConstantChannelsReport& report) {
+	std::cout << "Clip " << clipName << ": " << report.collapsed << " constant channels, " << report.removed
+		<< " channels equal to the rest pose removed, " << report.bytesSaved << " bytes saved, "
+		<< report.interpolationsSaved << " fewer track interpolations per sample\n";
+}
+
+void printKeyReductionReport(const std::string& clipName, const KeyReductionReport& report) {
+	std::cout << "Clip " << clipName << ": " << report.keysBefore << " keys reduced to " << report.keysAfter
+		<< " (max error: position " << report.maxPositionError << ", rotation " << report.maxRotationError
+		<< " rad, scale " << report.maxScaleError << ")\n";
+}
+
+// frame search benchmark
+namespace ClipHelpers {
+
+	enum FrameSearch { BACKWARD_SCAN = 0, BINARY_SEARCH, CURSOR, NUM_FRAME_SEARCHES };
+
+	// frame of a looping track at the time: the scan from the last frame of Track::frameIndex before the cursors,
+	// the binary search, or the search that starts at the frame of the cursor
+	template<typename T, int N>
+	inline int searchFrame(Track<T, N>& track, float time, FrameSearch search, TrackCursor* cursor) {
+		unsigned int size = track.size();
+		if (size <= 1) {
+			return 0;
+		}
+		if (search != BACKWARD_SCAN) {
+			float t;
+			return track.findSegment(time, true, t, search == CURSOR ? cursor : 0);
+		}
+		const float* times = track.getTimes();
+		float startTime = times[0];
+		float duration = times[size - 1] - startTime;
+		if (duration <= 0.0f) {
+			return -1;
+		}
+		time = fmodf(time - startTime, duration);
+		if (time < 0.0f) {
+			time += duration;
+		}
+		time = time + startTime;
+		for (int i = (int)size - 1; i >= 0; --i) {
+			if (time >= times[i]) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+}; // End Clip helpers namespace
+
+void printFrameSearchBenchmark(Clip& clip, Pose& pose, unsigned int loops) {
+	std::vector<TransformTrack*> tracks;
+	unsigned int numSearched = 0;
+	unsigned int numKeys = 0;
+	for (unsigned int i = 0, size = clip.size(); i < size; ++i) {
+		TransformTrack* track = clip.findTrack(clip.getIdAtIndex(i));
+		tracks.push_back(track);
+		unsigned int sizes[3] = { track->getPositionTrack().size(), track->getRotationTrack().size(), track->getScaleTrack().size() };
+		for (int c = 0; c < 3; ++c) {
+			if (sizes[c] > 1) {
+				++numSearched;
+				numKeys += sizes[c];
+			}
+		}
+	}
+	std::cout << "Frame search of clip " << clip.getName() << ": " << numSearched << " tracks of " <<
+		(numSearched > 0 ? numKeys / numSearched : 0) << " keys on average, played at 60 fps " << loops << " times\n";
+	float duration = clip.getDuration();
+	if (numSearched == 0 || duration <= 0.0f || loops == 0) {
+		return;
+	}
+
+	// sequential playback: every track searches the frame of each sample, the cursors keep the frame of the last one
+	unsigned int numSamples = (unsigned int)(duration * 60.0f) + 1;
+	const char* names[ClipHelpers::NUM_FRAME_SEARCHES] = { "backward scan", "binary search", "cursor" };
+	double seconds[ClipHelpers::NUM_FRAME_SEARCHES];
+	long long checksums[ClipHelpers::NUM_FRAME_SEARCHES];
+	std::vector<TrackCursor> cursors(tracks.size() * 3);
+	for (int search = 0; search < ClipHelpers::NUM_FRAME_SEARCHES; ++search) {
+		ClipHelpers::FrameSearch frameSearch = (ClipHelpers::FrameSearch)search;
+		for (unsigned int i = 0, size = (unsigned int)cursors.size(); i < size; ++i) {
+			cursors[i].frame = -1;
+		}
+		long long checksum = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int loop = 0; loop < loops; ++loop) {
+			for (unsigned int s = 0; s < numSamples; ++s) {
+				float time = clip.getStartTime() + (float)s / 60.0f;
+				for (unsigned int i = 0, size = (unsigned int)tracks.size(); i < size; ++i) {
+					TrackCursor* trackCursors = &cursors[i * 3];
+					checksum += ClipHelpers::searchFrame(tracks[i]->getPositionTrack(), time, frameSearch, &trackCursors[0]);
+					checksum += ClipHelpers::searchFrame(tracks[i]->getRotationTrack(), time, frameSearch, &trackCursors[1]);
+					checksum += ClipHelpers::searchFrame(tracks[i]->getScaleTrack(), time, frameSearch, &trackCursors[2]);
+				}
+			}
+		}
+		seconds[search] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		checksums[search] = checksum;
+	}
+	double numSearches = (double)numSearched * numSamples * loops;
+	for (int search = 0; search < ClipHelpers::NUM_FRAME_SEARCHES; ++search) {
+		std::cout << "  " << names[search] << ": " << seconds[search] * 1e9 / numSearches << " ns per track (x" <<
+			seconds[0] / seconds[search] << ")" << (checksums[search] != checksums[0] ? ", DIFFERENT FRAMES" : "") << "\n";
+	}
+
+	// the whole sample of the clip (shared timelines and interpolation included), without and with a ClipCursor
+	ClipCursor clipCursor;
+	for (int withCursor = 0; withCursor < 2; ++withCursor) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int loop = 0; loop < loops; ++loop) {
+			for (unsigned int s = 0; s < numSamples; ++s) {
+				clip.sample(pose, clip.getStartTime() + (float)s / 60.0f, withCursor ? &clipCursor : 0);
+			}
+		}
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  Clip::sample " << (withCursor ? "with" : "without") << " cursor: " << elapsed * 1e6 / (numSamples * loops) << " us per sample\n";
+	}
+}
+
+// cubic bake report
+namespace ClipHelpers {
+
+	// bakes a cubic copy of the track (Catmull-Rom tangents if the track is linear) and returns the error of the bake
+	template<typename T, int N>
+	inline float cubicBakeError(Track<T, N>& track, unsigned int samplesPerSegment, unsigned int& numTracks) {
+		unsigned int size = track.size();
+		if (size <= 1 || track.getInterpolation() == Interpolation::Constant) {
+			return 0.0f;
+		}
+		Track<T, N> cubic = track;
+		if (cubic.getInterpolation() != Interpolation::Cubic) {
+			cubic.setInterpolation(Interpolation::Cubic);
+			const float* times = cubic.getTimes();
+			const float* values = cubic.getValues();
+			for (unsigned int i = 0; i < size; ++i) {
+				unsigned int prev = i > 0 ? i - 1 : i;
+				unsigned int next = i < size - 1 ? i + 1 : i;
+				float* in = cubic.getInTangent(i);
+				float* out = cubic.getOutTangent(i);
+				for (int j = 0; j < N; ++j) {
+					in[j] = out[j] = (values[next * N + j] - values[prev * N + j]) / (times[next] - times[prev]);
+				}
+			}
+		}
+		cubic.bakeCubic();
+		++numTracks;
+		return cubic.getBakeError(samplesPerSegment);
+	}
+}; // End Clip helpers namespace
+
+void printCubicBakeReport(Clip& clip, unsigned int samplesPerSegment) {
+	unsigned int numTracks = 0;
+	float positionError = 0.0f;
+	float rotationError = 0.0f;
+	float scaleError = 0.0f;
+	for (unsigned int i = 0, size = clip.size(); i < size; ++i) {
+		TransformTrack& track = clip[clip.getIdAtIndex(i)];
+		positionError = fmaxf(positionError, ClipHelpers::cubicBakeError(track.getPositionTrack(), samplesPerSegment, numTracks));
+		rotationError = fmaxf(rotationError, ClipHelpers::cubicBakeError(track.getRotationTrack(), samplesPerSegment, numTracks));
+		scaleError = fmaxf(scaleError, ClipHelpers::cubicBakeError(track.getScaleTrack(), samplesPerSegment, numTracks));
+	}
+	std::cout << "Cubic bake of clip " << clip.getName() << ": " << numTracks << " tracks, " << samplesPerSegment
+		<< " samples per segment, max difference to hermite: position " << positionError << ", rotation "
+		<< rotationError << ", scale " << scaleError << "\n";
+}
+
+// clip cursor
+void ClipCursor::reset() {
+	for (unsigned int i = 0, size = (unsigned int)cursors.size(); i < size; ++i) {
+		cursors[i].frame = -1;
+	}
+	for (unsigned int i = 0, size = (unsigned int)timelineCursors.size(); i < size; ++i) {
+		timelineCursors[i].frame = -1;
+	}
+}
+
+void ClipCursor::resize(unsigned int numTracks, unsigned int numTimelines) {
+	cursors.resize(numTracks * 3);
+	timelineCursors.resize(numTimelines);
+	reset();
+}
+
+unsigned int ClipCursor::size() {
+	return (unsigned int)cursors.size() / 3;
+}
+
+unsigned int ClipCursor::getNumTimelines() {
+	return (unsigned int)timelineCursors.size();
+}
+
+TrackCursor* ClipCursor::getTimelineCursor(unsigned int index) {
+	return &timelineCursors[index];
+}
+
+TrackCursor* ClipCursor::getTrackCursors(unsigned int index) {
+	return &cursors[index * 3];
 }
\ No newline at end of file
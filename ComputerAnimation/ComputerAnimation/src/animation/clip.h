@@ -4,19 +4,62 @@
 #include "transformTrack.h"
 #include "pose.h"
 
-class Clip {
+// Playback state of a clip: the cursors of the position, rotation and scale tracks of every transform track.
+// Each character playing a clip keeps its own cursor, so sequential playback doesn't search the frames again.
+class ClipCursor {
 protected:
-	std::vector<TransformTrack> tracks;
+	std::vector<TrackCursor> cursors;
+	std::vector<TrackCursor> timelineCursors;
+public:
+	// forget the cached frames (after jumping to another clip, for example)
+	void reset();
+	void resize(unsigned int numTracks, unsigned int numTimelines = 0);
+	unsigned int size();
+	unsigned int getNumTimelines();
+	// returns the three cursors of the transform track at the given index
+	TrackCursor* getTrackCursors(unsigned int index);
+	TrackCursor* getTimelineCursor(unsigned int index);
+};
+
+template <typename TRACK>
+class TClip {
+protected:
+	std::vector<TRACK> tracks;
+	std::vector<int> trackIndices; // index in tracks of every joint id, -1 if the joint has no track
 	std::string name;
 	float startTime;
 	float endTime;
 	bool looping;
+	// indices of the tracks with an animated position, rotation or scale, grouped by interpolation (Constant, Linear, Cubic),
+	// so that sample runs a loop per group instead of checking the interpolation of every component track
+	std::vector<unsigned int> positionGroups[3];
+	std::vector<unsigned int> rotationGroups[3];
+	std::vector<unsigned int> scaleGroups[3];
+	bool grouped; // false after the tracks are accessed for writing, the groups are rebuilt by the next sample
+	// times shared by the component tracks (see shareTimelines), rebuilt with the groups
+	std::vector<Timeline> timelines;
+	std::vector<int> timelineIndices; // 3 per track: timeline of the position, rotation and scale, -1 if the track searches its own times
+	std::vector<int> segmentFrames; // segment of every timeline at the sampled time
+	std::vector<float> segmentTimes;
+	bool shareTimes;
 
 protected:
 	float adjustTimeToFitRange(float inTime);
+	void groupTracks();
+	void buildTimelines();
+	// finds the segment of every timeline, once for all the tracks that share it
+	void findSegments(float time, ClipCursor* cursor);
+	inline int getTimeline(unsigned int index, int component) {
+		return timelineIndices.empty() ? -1 : timelineIndices[index * 3 + component];
+	}
+	void setTrackIndex(unsigned int joint, int index);
+	template <typename POLICY>
+	void sampleGroups(Pose& outPose, float time, ClipCursor* cursor);
+	// linear groups are interpolated 4 tracks at a time with SSE and written straight into the pose
+	void sampleLinearGroups(Pose& outPose, float time, ClipCursor* cursor);
 
 public:
-	Clip();
+	TClip();
 
 	//gets joint Id based for a specific track index
 	unsigned int getIdAtIndex(unsigned int index);
@@ -24,13 +67,24 @@ public:
 	void setIdAtIndex(unsigned int idx, unsigned int id);
 	unsigned int size();
 
-	//samples the animation clip at the provided time into the Pose reference
-	float sample(Pose& outPose, float inTime);
-	//returns a transform track for the specified joint
-	TransformTrack& operator[](unsigned int index);
+	//samples the animation clip at the provided time into the Pose reference (the cursor is optional).
+	//Only the channels with frames are written, a channel with a single frame sets its value. The joints and channels
+	//without a track (e.g. removed by removeConstantChannels) keep the values of outPose, which usually starts as the rest pose
+	float sample(Pose& outPose, float inTime, ClipCursor* cursor = 0);
+	//returns a transform track for the specified joint (the interpolation of its tracks can be changed through it)
+	TRACK& operator[](unsigned int index);
+	//returns the transform track of the joint, or 0 if the joint has no track (it doesn't create one)
+	TRACK* findTrack(unsigned int joint);
+	const TRACK* findTrack(unsigned int joint) const;
 
 	//sets the start/end time of the animation clip based on the tracks that make up the clip
 	void recalculateDuration();
+	// the component tracks with the same times (usually all the tracks of a clip) share a timeline: they keep a single
+	// array of times, and the segment of the sampled time is found once per timeline instead of once per track (the
+	// loaders call it after building the clip)
+	void shareTimelines();
+	bool getShareTimelines();
+	unsigned int getNumTimelines();
 
 	std::string& getName();
 	void setName(const std::string& inNewName);
@@ -40,3 +94,59 @@ public:
 	bool getLooping();
 	void setLooping(bool inLooping);
 };
+
+typedef TClip<TransformTrack> Clip;
+typedef TClip<FastTransformTrack> FastClip;
+
+// converts every track of the clip into a fast track (to be done once, after loading the clip)
+FastClip optimizeClip(Clip& input);
+
+// result of removeConstantChannels
+struct ConstantChannelsReport {
+	unsigned int collapsed; // channels reduced to a single frame
+	unsigned int removed; // channels removed because they match the rest pose
+	unsigned int bytesSaved;
+	unsigned int interpolationsSaved; // component tracks that each sample of the clip no longer searches and interpolates
+
+	inline ConstantChannelsReport() : collapsed(0), removed(0), bytesSaved(0), interpolationsSaved(0) { }
+};
+
+// Detects the position, rotation and scale channels whose frames all have the same value (within the tolerance).
+// A constant channel keeps a single frame, or is removed when its value is the one of the rest pose
+// (the pose given to sample must then start as the rest pose).
+// To be done once after loading the clip (before optimizeClip).
+ConstantChannelsReport removeConstantChannels(Clip& clip, Pose& restPose, float tolerance = 0.0001f);
+void printConstantChannelsReport(const std::string& clipName, const ConstantChannelsReport& report);
+
+// key reduction done by the loaders at import time (disabled by default)
+struct KeyReductionOptions {
+	bool enabled;
+	float positionTolerance; // distance, in the units of the clip
+	float rotationTolerance; // angle, in radians
+	float scaleTolerance;
+
+	inline KeyReductionOptions() : enabled(false), positionTolerance(0.001f), rotationTolerance(0.001f), scaleTolerance(0.001f) { }
+};
+
+// result of reduceKeys
+struct KeyReductionReport {
+	unsigned int keysBefore;
+	unsigned int keysAfter;
+	float maxPositionError;
+	float maxRotationError; // radians
+	float maxScaleError;
+
+	inline KeyReductionReport() : keysBefore(0), keysAfter(0), maxPositionError(0.0f), maxRotationError(0.0f), maxScaleError(0.0f) { }
+};
+
+// removes the frames of the linear tracks of the clip that the remaining frames reconstruct within the tolerances
+KeyReductionReport reduceKeys(Clip& clip, const KeyReductionOptions& options);
+void printKeyReductionReport(const std::string& clipName, const KeyReductionReport& report);
+
+// plays the clip at 60 fps and prints the time to find the frames of its tracks with the backward scan of the original
+// Track::frameIndex, the binary search and the playback cursors, and the time of Clip::sample without and with a cursor
+void printFrameSearchBenchmark(Clip& clip, Pose& pose, unsigned int loops = 10);
+
+// Bakes a cubic copy of every track of the clip and prints the largest difference between the baked polynomials and the
+// Hermite basis functions. Linear tracks get Catmull-Rom tangents, so the check also runs on clips without cubic splines.
+void printCubicBakeReport(Clip& clip, unsigned int samplesPerSegment = 8);
\ No newline at end of file
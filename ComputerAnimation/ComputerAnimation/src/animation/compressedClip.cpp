@@ -0,0 +1,651 @@
+#include "compressedClip.h"
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+// Quantization of the frames
+namespace CompressionHelpers {
+
+	// range of the three smallest components of a unit quaternion
+	const float QUAT_RANGE = 0.70710678f;
+	// bits of each quantized component
+	const unsigned int MIN_BITS = 4;
+	const unsigned int MAX_VECTOR_BITS = 16;
+	const unsigned int MAX_ROTATION_BITS = 15;
+
+	// the values are stored from the least significant bit of the shorts of the stream, so a value can use the end of a
+	// short and the beginning of the next one
+	inline unsigned int readBits(const unsigned short* stream, unsigned int bit, unsigned int count) {
+		const unsigned short* word = &stream[bit >> 4];
+		unsigned int shift = bit & 15;
+		unsigned int window = word[0];
+		if (shift + count > 16) {
+			window |= (unsigned int)word[1] << 16;
+		}
+		return (window >> shift) & ((1u << count) - 1u);
+	}
+
+	inline void writeBits(unsigned short* stream, unsigned int bit, unsigned int count, unsigned int value) {
+		for (unsigned int i = 0; i < count; ++i, ++bit) {
+			if (value & (1u << i)) {
+				stream[bit >> 4] |= (unsigned short)(1u << (bit & 15));
+			}
+		}
+	}
+
+	// bits of a frame of a channel
+	inline unsigned int vectorFrameBits(const CompressedChannel& channel) {
+		return 3 * channel.bits;
+	}
+
+	inline unsigned int rotationFrameBits(const CompressedChannel& channel) {
+		return 2 + 3 * channel.bits;
+	}
+
+	inline unsigned int quantize(float value, float min, float extent, unsigned int bits) {
+		if (extent <= 0.0f) {
+			return 0;
+		}
+		float normalizedValue = (value - min) / extent;
+		return (unsigned int)(fminf(fmaxf(normalizedValue, 0.0f), 1.0f) * (float)((1u << bits) - 1u) + 0.5f);
+	}
+
+	inline float dequantize(unsigned int value, float min, float extent, unsigned int bits) {
+		return min + extent * ((float)value / (float)((1u << bits) - 1u));
+	}
+
+	inline void packVector(const vec3& v, const CompressedChannel& channel, unsigned short* stream, unsigned int bit) {
+		for (unsigned int i = 0; i < 3; ++i) {
+			writeBits(stream, bit + i * channel.bits, channel.bits, quantize(v.v[i], channel.min.v[i], channel.extent.v[i], channel.bits));
+		}
+	}
+
+	inline vec3 unpackVector(const CompressedChannel& channel, const unsigned short* stream, unsigned int bit) {
+		unsigned int bits = channel.bits;
+		return vec3(
+			dequantize(readBits(stream, bit, bits), channel.min.x, channel.extent.x, bits),
+			dequantize(readBits(stream, bit + bits, bits), channel.min.y, channel.extent.y, bits),
+			dequantize(readBits(stream, bit + 2 * bits, bits), channel.min.z, channel.extent.z, bits));
+	}
+
+	// Smallest three: the largest component of a unit quaternion is rebuilt from the other three, which are in the range
+	// [-1/sqrt(2), 1/sqrt(2)]. 2 bits store the index of the largest component, followed by the other three.
+	inline void packQuaternion(const quat& _q, unsigned int bits, unsigned short* stream, unsigned int bit) {
+		quat q = normalized(_q);
+		int largest = 0;
+		for (int i = 1; i < 4; ++i) {
+			if (fabsf(q.v[i]) > fabsf(q.v[largest])) {
+				largest = i;
+			}
+		}
+		// q and -q are the same rotation, the largest component is made positive so that its sign doesn't need to be stored
+		if (q.v[largest] < 0.0f) {
+			q = -q;
+		}
+		writeBits(stream, bit, 2, (unsigned int)largest);
+		bit += 2;
+		for (int i = 0; i < 4; ++i) {
+			if (i == largest) {
+				continue;
+			}
+			writeBits(stream, bit, bits, quantize(q.v[i], -QUAT_RANGE, 2.0f * QUAT_RANGE, bits));
+			bit += bits;
+		}
+	}
+
+	inline quat unpackQuaternion(unsigned int bits, const unsigned short* stream, unsigned int bit) {
+		int largest = (int)readBits(stream, bit, 2);
+		bit += 2;
+		quat result;
+		float sumSq = 0.0f;
+		for (int i = 0; i < 4; ++i) {
+			if (i == largest) {
+				continue;
+			}
+			result.v[i] = dequantize(readBits(stream, bit, bits), -QUAT_RANGE, 2.0f * QUAT_RANGE, bits);
+			sumSq += result.v[i] * result.v[i];
+			bit += bits;
+		}
+		result.v[largest] = sqrtf(fmaxf(1.0f - sumSq, 0.0f));
+		return result;
+	}
+
+	// range of the values of a vector channel
+	inline void vectorRange(const std::vector<vec3>& values, vec3& min, vec3& extent) {
+		min = values[0];
+		vec3 max = values[0];
+		for (unsigned int i = 1, size = (unsigned int)values.size(); i < size; ++i) {
+			for (int j = 0; j < 3; ++j) {
+				min.v[j] = fminf(min.v[j], values[i].v[j]);
+				max.v[j] = fmaxf(max.v[j], values[i].v[j]);
+			}
+		}
+		extent = max - min;
+	}
+
+	// times of the frames of a compressed channel: the frames of linear tracks with uniform times are kept,
+	// the frames of the other tracks are resampled at the frame rate
+	template<typename T, int N>
+	inline void channelFrames(Track<T, N>& track, float frameRate, CompressedChannel& channel) {
+		unsigned int size = track.size();
+		channel.startTime = size > 0 ? track.getTime(0) : 0.0f;
+		if (size <= 1) {
+			channel.frames = size;
+			return;
+		}
+		float duration = track.getEndTime() - channel.startTime;
+		if (duration <= 0.0f) {
+			channel.frames = 1;
+			return;
+		}
+		bool uniform = track.getInterpolation() == Interpolation::Linear;
+		float frameDuration = duration / (float)(size - 1);
+		for (unsigned int i = 1; i < size - 1 && uniform; ++i) {
+			uniform = fabsf(track.getTime(i) - (channel.startTime + (float)i * frameDuration)) <= frameDuration * 0.01f; // the times of the loaders are accumulated in floats
+		}
+		channel.frames = uniform ? size : (unsigned int)ceilf(duration * frameRate) + 1;
+		channel.frameRate = (float)(channel.frames - 1) / duration; // the last frame is at the end of the track
+	}
+
+	// changes the number of frames of a channel, keeping the time range of the channel with all the frames
+	inline void setFrames(CompressedChannel& channel, const CompressedChannel& full, unsigned int frames) {
+		channel.frames = frames;
+		if (full.frames > 1) {
+			channel.frameRate = full.frameRate * (float)(frames - 1) / (float)(full.frames - 1);
+		}
+	}
+
+	// value of the frame of a channel, the time is always in the range of the track
+	template<typename T, int N>
+	inline T channelValue(Track<T, N>& track, const CompressedChannel& channel, unsigned int frame) {
+		if (channel.frames <= 1) {
+			return track.sample(channel.startTime, false);
+		}
+		return track.sample(channel.startTime + (float)frame / channel.frameRate, false);
+	}
+
+	// appends the quantized frames of a channel to the bit stream
+	inline void encodeVectors(VectorTrack& track, CompressedChannel& channel, std::vector<unsigned short>& data) {
+		if (channel.frames == 0) {
+			return;
+		}
+		std::vector<vec3> values(channel.frames);
+		for (unsigned int f = 0; f < channel.frames; ++f) {
+			values[f] = channelValue(track, channel, f);
+		}
+		vectorRange(values, channel.min, channel.extent);
+		channel.offset = (unsigned int)data.size();
+		unsigned int frameBits = vectorFrameBits(channel);
+		data.resize(data.size() + (channel.frames * frameBits + 15) / 16, 0);
+		for (unsigned int f = 0; f < channel.frames; ++f) {
+			packVector(values[f], channel, &data[channel.offset], f * frameBits);
+		}
+	}
+
+	inline void encodeRotations(QuaternionTrack& track, CompressedChannel& channel, std::vector<unsigned short>& data) {
+		if (channel.frames == 0) {
+			return;
+		}
+		channel.offset = (unsigned int)data.size();
+		unsigned int frameBits = rotationFrameBits(channel);
+		data.resize(data.size() + (channel.frames * frameBits + 15) / 16, 0);
+		for (unsigned int f = 0; f < channel.frames; ++f) {
+			packQuaternion(channelValue(track, channel, f), channel.bits, &data[channel.offset], f * frameBits);
+		}
+	}
+
+	// frames and bits of the channels of a track with the highest precision
+	inline CompressedTrack fullLayout(TransformTrack& track, float frameRate) {
+		CompressedTrack layout;
+		layout.id = track.getId();
+		channelFrames(track.getPositionTrack(), frameRate, layout.position);
+		channelFrames(track.getRotationTrack(), frameRate, layout.rotation);
+		channelFrames(track.getScaleTrack(), frameRate, layout.scale);
+		layout.position.bits = MAX_VECTOR_BITS;
+		layout.rotation.bits = MAX_ROTATION_BITS;
+		layout.scale.bits = MAX_VECTOR_BITS;
+		return layout;
+	}
+}; // End Compression helpers namespace
+
+CompressedClip::CompressedClip() {
+	name = "No name given";
+	startTime = 0.0f;
+	endTime = 0.0f;
+	looping = true;
+}
+
+float CompressedClip::sample(Pose& outPose, float time) {
+	if (getDuration() == 0.0f) {
+		return 0.0f;
+	}
+	time = adjustTimeToFitRange(time);
+	for (unsigned int i = 0, size = (unsigned int)tracks.size(); i < size; ++i) {
+		CompressedTrack& track = tracks[i];
+		// channels without frames keep the value of the pose
+		Transform local = outPose.getLocalTransform(track.id);
+		if (track.position.frames > 0) {
+			local.position = sampleVector(track.position, time);
+		}
+		if (track.rotation.frames > 0) {
+			local.rotation = sampleRotation(track.rotation, time);
+		}
+		if (track.scale.frames > 0) {
+			local.scale = sampleVector(track.scale, time);
+		}
+		outPose.setLocalTransform(track.id, local);
+	}
+	return time;
+}
+
+// the frames are uniform, so the frame on the left of the time is found with a multiplication
+unsigned int CompressedClip::frameIndex(const CompressedChannel& channel, float time, float& t) {
+	t = 0.0f;
+	if (channel.frames <= 1) {
+		return 0;
+	}
+	unsigned int lastFrame = channel.frames - 1;
+	float frameTime = (time - channel.startTime) * channel.frameRate;
+	// like the tracks of a Clip, a looping clip wraps the time in the range of the channel, otherwise it's clamped
+	if (looping) {
+		frameTime = fmodf(frameTime, (float)lastFrame);
+		if (frameTime < 0.0f) {
+			frameTime += (float)lastFrame;
+		}
+	}
+	else if (frameTime <= 0.0f) {
+		return 0;
+	}
+	unsigned int frame = (unsigned int)frameTime;
+	if (frame >= lastFrame) {
+		return lastFrame;
+	}
+	t = frameTime - (float)frame;
+	return frame;
+}
+
+vec3 CompressedClip::sampleVector(const CompressedChannel& channel, float time) {
+	float t;
+	unsigned int frame = frameIndex(channel, time, t);
+	unsigned int frameBits = CompressionHelpers::vectorFrameBits(channel);
+	vec3 a = CompressionHelpers::unpackVector(channel, &data[channel.offset], frame * frameBits);
+	if (t <= 0.0f) {
+		return a;
+	}
+	vec3 b = CompressionHelpers::unpackVector(channel, &data[channel.offset], (frame + 1) * frameBits);
+	return lerp(a, b, t);
+}
+
+quat CompressedClip::sampleRotation(const CompressedChannel& channel, float time) {
+	float t;
+	unsigned int frame = frameIndex(channel, time, t);
+	unsigned int frameBits = CompressionHelpers::rotationFrameBits(channel);
+	quat a = CompressionHelpers::unpackQuaternion(channel.bits, &data[channel.offset], frame * frameBits);
+	if (t <= 0.0f) {
+		return a;
+	}
+	quat b = CompressionHelpers::unpackQuaternion(channel.bits, &data[channel.offset], (frame + 1) * frameBits);
+	if (dot(a, b) < 0.0f) { // Neighborhood
+		b = -b;
+	}
+	return nlerp(a, b, t);
+}
+
+void CompressedClip::addTrack(TransformTrack& track, const CompressedTrack& layout) {
+	CompressedTrack result = layout;
+	CompressionHelpers::encodeVectors(track.getPositionTrack(), result.position, data);
+	CompressionHelpers::encodeRotations(track.getRotationTrack(), result.rotation, data);
+	CompressionHelpers::encodeVectors(track.getScaleTrack(), result.scale, data);
+	tracks.push_back(result);
+}
+
+float CompressedClip::adjustTimeToFitRange(float inTime) {
+	float duration = endTime - startTime;
+	if (duration <= 0.0f) {
+		return startTime;
+	}
+	if (looping) {
+		inTime = fmodf(inTime - startTime, duration);
+		if (inTime < 0.0f) {
+			inTime += duration;
+		}
+		inTime = inTime + startTime;
+	}
+	else {
+		if (inTime < startTime) {
+			inTime = startTime;
+		}
+		if (inTime > endTime) {
+			inTime = endTime;
+		}
+	}
+	return inTime;
+}
+
+// getters
+unsigned int CompressedClip::size() {
+	return (unsigned int)tracks.size();
+}
+
+unsigned int CompressedClip::getIdAtIndex(unsigned int index) {
+	return tracks[index].id;
+}
+
+CompressedTrack& CompressedClip::getTrack(unsigned int index) {
+	return tracks[index];
+}
+
+unsigned int CompressedClip::getNumFrames() {
+	unsigned int frames = 0;
+	for (unsigned int i = 0, size = (unsigned int)tracks.size(); i < size; ++i) {
+		frames += tracks[i].position.frames + tracks[i].rotation.frames + tracks[i].scale.frames;
+	}
+	return frames;
+}
+
+unsigned int CompressedClip::getByteSize() {
+	return (unsigned int)(data.size() * sizeof(unsigned short) + tracks.size() * sizeof(CompressedTrack));
+}
+
+std::string& CompressedClip::getName() {
+	return name;
+}
+
+float CompressedClip::getDuration() {
+	return endTime - startTime;
+}
+
+float CompressedClip::getStartTime() {
+	return startTime;
+}
+
+float CompressedClip::getEndTime() {
+	return endTime;
+}
+
+bool CompressedClip::getLooping() {
+	return looping;
+}
+
+// setters
+void CompressedClip::setLooping(bool inLooping) {
+	looping = inLooping;
+}
+
+CompressedClip compressClip(Clip& input, float frameRate) {
+	CompressedClip result;
+	result.name = input.getName();
+	result.looping = input.getLooping();
+	result.startTime = input.getStartTime();
+	result.endTime = input.getEndTime();
+	for (unsigned int i = 0, size = input.size(); i < size; ++i) {
+		TransformTrack& track = *input.findTrack(input.getIdAtIndex(i));
+		result.addTrack(track, CompressionHelpers::fullLayout(track, frameRate));
+	}
+	return result;
+}
+
+// Error measures
+namespace CompressionHelpers {
+
+	// model space virtual points of the original clip, sampled at uniform times
+	struct ErrorMeasure {
+		std::vector<float> times;
+		std::vector<Pose> poses; // original local transforms, the compressed channels are sampled on top of them
+		vec3 points[3]; // virtual points, in the space of each joint
+		std::vector<vec3> modelPoints; // 3 points of every joint at every time
+		std::vector<std::vector<unsigned int> > subtrees; // each joint and its descendants
+		float unitsPerCentimeter;
+	};
+
+	inline vec3 modelPoint(const Transform& global, const vec3& point) {
+		return global.position + global.rotation * (global.scale * point);
+	}
+
+	// error of the 3 virtual points of a joint, in centimeters
+	inline float pointsError(const Transform& global, ErrorMeasure& measure, unsigned int index) {
+		float error = 0.0f;
+		for (unsigned int k = 0; k < 3; ++k) {
+			vec3 difference = modelPoint(global, measure.points[k]) - measure.modelPoints[index * 3 + k];
+			error = fmaxf(error, sqrtf(lenSq(difference)));
+		}
+		return error / measure.unitsPerCentimeter;
+	}
+
+	// the clip is measured twice per frame of the frame rate of the settings
+	inline void buildErrorMeasure(Clip& original, Skeleton& skeleton, const CompressionSettings& settings, ErrorMeasure& measure) {
+		Pose& restPose = skeleton.getRestPose();
+		unsigned int numJoints = restPose.size();
+		float distance = settings.virtualPointDistance * settings.unitsPerCentimeter;
+		measure.points[0] = vec3(distance, 0.0f, 0.0f);
+		measure.points[1] = vec3(0.0f, distance, 0.0f);
+		measure.points[2] = vec3(0.0f, 0.0f, distance);
+		measure.unitsPerCentimeter = settings.unitsPerCentimeter;
+
+		measure.subtrees.assign(numJoints, std::vector<unsigned int>());
+		for (unsigned int i = 0; i < numJoints; ++i) {
+			for (int joint = (int)i; joint >= 0; joint = restPose.getParent(joint)) {
+				measure.subtrees[joint].push_back(i);
+			}
+		}
+
+		float duration = original.getDuration();
+		unsigned int intervals = (unsigned int)ceilf(duration * settings.frameRate * 2.0f);
+		if (intervals == 0) {
+			intervals = 1;
+		}
+		// the end of a looping clip is its start
+		unsigned int numTimes = original.getLooping() ? intervals : intervals + 1;
+		measure.times.resize(numTimes);
+		measure.poses.assign(numTimes, restPose);
+		measure.modelPoints.resize(numTimes * numJoints * 3);
+		for (unsigned int t = 0; t < numTimes; ++t) {
+			measure.times[t] = original.getStartTime() + duration * (float)t / (float)intervals;
+			original.sample(measure.poses[t], measure.times[t]);
+			for (unsigned int j = 0; j < numJoints; ++j) {
+				Transform global = measure.poses[t].getGlobalTransform(j);
+				for (unsigned int k = 0; k < 3; ++k) {
+					measure.modelPoints[(t * numJoints + j) * 3 + k] = modelPoint(global, measure.points[k]);
+				}
+			}
+		}
+	}
+
+	// maximum error of a joint and its descendants when the compressed clip is sampled on top of the original poses.
+	// The measure stops as soon as the error is over the budget.
+	inline float subtreeError(CompressedClip& compressed, ErrorMeasure& measure, unsigned int joint, float budget) {
+		unsigned int numJoints = (unsigned int)measure.subtrees.size();
+		std::vector<unsigned int>& subtree = measure.subtrees[joint];
+		float maxError = 0.0f;
+		Pose pose;
+		for (unsigned int t = 0, numTimes = (unsigned int)measure.times.size(); t < numTimes && maxError <= budget; ++t) {
+			pose = measure.poses[t];
+			compressed.sample(pose, measure.times[t]);
+			for (unsigned int i = 0, size = (unsigned int)subtree.size(); i < size; ++i) {
+				maxError = fmaxf(maxError, pointsError(pose.getGlobalTransform(subtree[i]), measure, t * numJoints + subtree[i]));
+			}
+		}
+		return maxError;
+	}
+
+	// maximum error of every joint when the whole compressed clip is sampled
+	inline std::vector<float> jointErrors(CompressedClip& compressed, Skeleton& skeleton, ErrorMeasure& measure) {
+		unsigned int numJoints = (unsigned int)measure.subtrees.size();
+		std::vector<float> errors(numJoints, 0.0f);
+		Pose pose;
+		for (unsigned int t = 0, numTimes = (unsigned int)measure.times.size(); t < numTimes; ++t) {
+			pose = skeleton.getRestPose();
+			compressed.sample(pose, measure.times[t]);
+			for (unsigned int j = 0; j < numJoints; ++j) {
+				errors[j] = fmaxf(errors[j], pointsError(pose.getGlobalTransform(j), measure, t * numJoints + j));
+			}
+		}
+		return errors;
+	}
+
+	// number of frames and bits that can be chosen for a channel
+	struct ChannelCandidate {
+		unsigned int frames;
+		unsigned int bits;
+		unsigned int size; // bits of all the frames
+	};
+
+	inline bool smallerCandidate(const ChannelCandidate& a, const ChannelCandidate& b) {
+		return a.size < b.size;
+	}
+
+	// candidates of a channel from the smallest to the largest, the frames are halved from the frames of the track
+	inline std::vector<ChannelCandidate> channelCandidates(const CompressedChannel& full, bool rotation) {
+		std::vector<ChannelCandidate> result;
+		for (unsigned int frames = full.frames; ; frames = (frames - 1) / 2 + 1) {
+			for (unsigned int bits = MIN_BITS; bits <= full.bits; ++bits) {
+				ChannelCandidate candidate;
+				candidate.frames = frames;
+				candidate.bits = bits;
+				candidate.size = frames * (rotation ? 2 + 3 * bits : 3 * bits);
+				result.push_back(candidate);
+			}
+			if (frames <= 2) {
+				break;
+			}
+		}
+		std::stable_sort(result.begin(), result.end(), smallerCandidate);
+		return result;
+	}
+
+	// increases the precision of a channel by one step: one more bit and twice the frames. Returns false if it's already exact.
+	inline bool refineChannel(CompressedChannel& channel, const CompressedChannel& full) {
+		if (channel.bits == full.bits && channel.frames == full.frames) {
+			return false;
+		}
+		channel.bits = std::min(full.bits, channel.bits + 1);
+		setFrames(channel, full, std::min(full.frames, channel.frames * 2 - 1));
+		return true;
+	}
+
+	inline CompressedChannel& channelAt(CompressedTrack& track, int channel) {
+		return channel == 0 ? track.position : (channel == 1 ? track.rotation : track.scale);
+	}
+}; // End Compression helpers namespace
+
+CompressedClip compressClip(Clip& input, Skeleton& skeleton, const CompressionSettings& settings) {
+	CompressionHelpers::ErrorMeasure measure;
+	CompressionHelpers::buildErrorMeasure(input, skeleton, settings, measure);
+	Pose& restPose = skeleton.getRestPose();
+
+	CompressedClip result;
+	result.name = input.getName();
+	result.looping = input.getLooping();
+	result.startTime = input.getStartTime();
+	result.endTime = input.getEndTime();
+
+	// each channel gets the smallest precision that keeps its joint and the descendants in the budget, with the other
+	// channels exact
+	unsigned int numTracks = input.size();
+	std::vector<CompressedTrack> fullLayouts(numTracks);
+	std::vector<CompressedTrack> layouts(numTracks);
+	std::vector<int> jointTracks(restPose.size(), -1);
+	for (unsigned int i = 0; i < numTracks; ++i) {
+		TransformTrack& track = *input.findTrack(input.getIdAtIndex(i));
+		fullLayouts[i] = CompressionHelpers::fullLayout(track, settings.frameRate);
+		layouts[i] = fullLayouts[i];
+		jointTracks[track.getId()] = (int)i;
+		for (int c = 0; c < 3; ++c) {
+			CompressedChannel& full = CompressionHelpers::channelAt(fullLayouts[i], c);
+			if (full.frames == 0) {
+				continue;
+			}
+			std::vector<CompressionHelpers::ChannelCandidate> candidates = CompressionHelpers::channelCandidates(full, c == 1);
+			for (unsigned int k = 0, size = (unsigned int)candidates.size(); k < size; ++k) {
+				CompressedTrack single;
+				single.id = track.getId();
+				CompressedChannel& channel = CompressionHelpers::channelAt(single, c);
+				channel = full;
+				channel.bits = candidates[k].bits;
+				CompressionHelpers::setFrames(channel, full, candidates[k].frames);
+
+				CompressedClip test;
+				test.looping = result.looping;
+				test.startTime = result.startTime;
+				test.endTime = result.endTime;
+				test.addTrack(track, single);
+				if (CompressionHelpers::subtreeError(test, measure, track.getId(), settings.errorBudget) <= settings.errorBudget) {
+					CompressionHelpers::channelAt(layouts[i], c) = channel;
+					break;
+				}
+			}
+		}
+	}
+
+	// the errors of the channels add up along the hierarchy: the joints over the budget and their parents get more
+	// precision until every joint is in the budget
+	for (unsigned int iteration = 0; ; ++iteration) {
+		result.tracks.clear();
+		result.data.clear();
+		for (unsigned int i = 0; i < numTracks; ++i) {
+			result.addTrack(*input.findTrack(layouts[i].id), layouts[i]);
+		}
+		if (iteration == 32) {
+			break;
+		}
+		std::vector<float> errors = CompressionHelpers::jointErrors(result, skeleton, measure);
+		std::vector<bool> refined(numTracks, false);
+		bool changed = false;
+		for (unsigned int j = 0, numJoints = (unsigned int)errors.size(); j < numJoints; ++j) {
+			if (errors[j] <= settings.errorBudget) {
+				continue;
+			}
+			for (int joint = (int)j; joint >= 0; joint = restPose.getParent(joint)) {
+				int t = jointTracks[joint];
+				if (t < 0 || refined[t]) {
+					continue;
+				}
+				refined[t] = true;
+				for (int c = 0; c < 3; ++c) {
+					if (CompressionHelpers::channelAt(layouts[t], c).frames > 0) {
+						changed = CompressionHelpers::refineChannel(CompressionHelpers::channelAt(layouts[t], c), CompressionHelpers::channelAt(fullLayouts[t], c)) || changed;
+					}
+				}
+			}
+		}
+		if (!changed) {
+			break;
+		}
+	}
+	return result;
+}
+
+std::vector<float> measureCompressionError(Clip& original, CompressedClip& compressed, Skeleton& skeleton, const CompressionSettings& settings) {
+	CompressionHelpers::ErrorMeasure measure;
+	CompressionHelpers::buildErrorMeasure(original, skeleton, settings, measure);
+	return CompressionHelpers::jointErrors(compressed, skeleton, measure);
+}
+
+void printCompressionReport(Clip& original, CompressedClip& compressed, Skeleton& skeleton, const CompressionSettings& settings) {
+	std::vector<float> errors = measureCompressionError(original, compressed, skeleton, settings);
+	std::vector<int> jointTracks(errors.size(), -1);
+	for (unsigned int i = 0, size = compressed.size(); i < size; ++i) {
+		jointTracks[compressed.getIdAtIndex(i)] = (int)i;
+	}
+	unsigned int originalSize = 0;
+	for (unsigned int i = 0, size = original.size(); i < size; ++i) {
+		TransformTrack& track = *original.findTrack(original.getIdAtIndex(i));
+		originalSize += track.getPositionTrack().getByteSize() + track.getRotationTrack().getByteSize() + track.getScaleTrack().getByteSize();
+	}
+
+	std::cout << "Compressed clip " << compressed.getName() << ", error budget " << settings.errorBudget << " cm\n";
+	float maxError = 0.0f;
+	for (unsigned int j = 0, numJoints = (unsigned int)errors.size(); j < numJoints; ++j) {
+		maxError = fmaxf(maxError, errors[j]);
+		std::cout << "  " << skeleton.getJointName(j) << ": " << errors[j] << " cm";
+		if (jointTracks[j] >= 0) {
+			// frames x bits of each channel
+			CompressedTrack& track = compressed.getTrack(jointTracks[j]);
+			std::cout << " (position " << track.position.frames << "x" << track.position.bits
+				<< ", rotation " << track.rotation.frames << "x" << track.rotation.bits
+				<< ", scale " << track.scale.frames << "x" << track.scale.bits << ")";
+		}
+		std::cout << "\n";
+	}
+	std::cout << "  max error " << maxError << " cm, " << originalSize << " bytes -> " << compressed.getByteSize() << " bytes\n";
+}
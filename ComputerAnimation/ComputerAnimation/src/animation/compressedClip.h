@@ -0,0 +1,101 @@
+#pragma once
+#include <vector>
+#include <string>
+#include "clip.h"
+#include "pose.h"
+#include "skeleton.h"
+
+// Frames of a position, rotation or scale channel in a CompressedClip: they are stored in the bit stream of the clip,
+// starting at an offset. The frames are uniform, so their times are implied by the start time and the frame rate of the
+// channel. A channel has no frames if it isn't animated, or a single one if it's constant.
+struct CompressedChannel {
+	unsigned int frames;
+	unsigned int offset; // index of the first short of the channel in the data of the clip
+	unsigned int bits; // bits of each quantized component (a rotation also uses 2 bits for the index of its largest component)
+	float startTime;
+	float frameRate; // frames per second
+	// range of the quantized positions and scales: value = min + extent * quantized / (2^bits - 1)
+	vec3 min;
+	vec3 extent;
+
+	inline CompressedChannel() : frames(0), offset(0), bits(0), startTime(0.0f), frameRate(0.0f) { }
+};
+
+// channels of a joint
+struct CompressedTrack {
+	unsigned int id; // joint Id
+	CompressedChannel position;
+	CompressedChannel rotation;
+	CompressedChannel scale;
+
+	inline CompressedTrack() : id(0) { }
+};
+
+// Error budget of compressClip: the error is measured as the displacement of virtual points attached to the joints,
+// in model space, so the error of a joint includes the error of its parents.
+struct CompressionSettings {
+	float errorBudget; // maximum displacement of the virtual points, in centimeters
+	float virtualPointDistance; // distance of the virtual points to their joint, in centimeters
+	float unitsPerCentimeter; // 1 for skeletons in centimeters, 0.01 for skeletons in meters
+	float frameRate; // frame rate of the resampled tracks (and of the error measures)
+
+	inline CompressionSettings() : errorBudget(0.1f), virtualPointDistance(3.0f), unitsPerCentimeter(1.0f), frameRate(30.0f) { }
+};
+
+// Clip with quantized frames, to keep many clips in memory. Tracks with uniform frames keep them, the others are resampled
+// uniformly, so that the times aren't stored.
+// Positions and scales are quantized in the range of their channel, rotations use smallest three (the largest component
+// is rebuilt from the other three). The frames are decompressed while sampling.
+class CompressedClip {
+protected:
+	std::vector<CompressedTrack> tracks;
+	std::vector<unsigned short> data; // bit stream with the frames of all the channels
+	std::string name;
+	float startTime;
+	float endTime;
+	bool looping;
+
+protected:
+	float adjustTimeToFitRange(float inTime);
+	// finds the frame on the left of the time in the channel and the interpolation factor t towards the next frame
+	unsigned int frameIndex(const CompressedChannel& channel, float time, float& t);
+	vec3 sampleVector(const CompressedChannel& channel, float time);
+	quat sampleRotation(const CompressedChannel& channel, float time);
+	// quantizes the channels of the track with the frames and bits of the layout
+	void addTrack(TransformTrack& track, const CompressedTrack& layout);
+
+public:
+	CompressedClip();
+
+	//samples the animation clip at the provided time into the Pose reference
+	float sample(Pose& outPose, float inTime);
+
+	unsigned int size();
+	unsigned int getIdAtIndex(unsigned int index);
+	CompressedTrack& getTrack(unsigned int index);
+	// number of frames of all the channels
+	unsigned int getNumFrames();
+	// bytes used by the frames and the tracks of the clip
+	unsigned int getByteSize();
+
+	std::string& getName();
+	float getDuration();
+	float getStartTime();
+	float getEndTime();
+	bool getLooping();
+	void setLooping(bool inLooping);
+
+	friend CompressedClip compressClip(Clip& input, float frameRate);
+	friend CompressedClip compressClip(Clip& input, Skeleton& skeleton, const CompressionSettings& settings);
+};
+
+// quantizes the frames of the clip with 16 bits per component (15 for rotations), the tracks that aren't uniform are
+// resampled at the given frame rate (to be done once, after loading the clip)
+CompressedClip compressClip(Clip& input, float frameRate = 30.0f);
+// chooses the bits and the number of frames of every channel so that the virtual points of all the joints stay within
+// the error budget. Coarse joints near the root get more precision than the leaves.
+CompressedClip compressClip(Clip& input, Skeleton& skeleton, const CompressionSettings& settings);
+// maximum error of every joint of the compressed clip (in centimeters), measured like compressClip does
+std::vector<float> measureCompressionError(Clip& original, CompressedClip& compressed, Skeleton& skeleton, const CompressionSettings& settings);
+// prints the error of every joint and the size of the compressed clip
+void printCompressionReport(Clip& original, CompressedClip& compressed, Skeleton& skeleton, const CompressionSettings& settings);
@@ -0,0 +1,323 @@
+#include "deltaClip.h"
+#include <cmath>
+#include <algorithm>
+
+// Encoding of the frames
+namespace DeltaHelpers {
+
+	inline int quantize(float value, float step) {
+		return (int)floorf(value / step + 0.5f);
+	}
+
+	// the differences are zigzag encoded (small negative values become small positive values) and written 7 bits per
+	// byte, so most of them use a single byte
+	inline void writeDelta(std::vector<unsigned char>& stream, int delta) {
+		unsigned int value = ((unsigned int)delta << 1) ^ (unsigned int)(delta >> 31);
+		while (value >= 0x80) {
+			stream.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		stream.push_back((unsigned char)value);
+	}
+
+	inline int readDelta(const unsigned char* stream, unsigned int& offset) {
+		unsigned int value = 0;
+		unsigned int shift = 0;
+		unsigned char byte;
+		do {
+			byte = stream[offset++];
+			value |= (unsigned int)(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+		return (int)(value >> 1) ^ -(int)(value & 1);
+	}
+
+	// key rate of the track, 0 if the track isn't animated
+	template<typename T, int N>
+	inline float keyRate(Track<T, N>& track) {
+		unsigned int size = track.size();
+		if (size <= 1) {
+			return 0.0f;
+		}
+		float duration = track.getEndTime() - track.getTime(0);
+		return duration > 0.0f ? (float)(size - 1) / duration : 0.0f;
+	}
+}; // End Delta helpers namespace
+
+void DeltaCursor::reset() {
+	frame = NO_FRAME;
+	hasPrevious = false;
+	readOffset = 0;
+}
+
+DeltaClip::DeltaClip() {
+	numValues = 0;
+	numFrames = 0;
+	keyInterval = 1;
+	frameRate = 0.0f;
+	positionStep = 0.0f;
+	scaleStep = 0.0f;
+	name = "No name given";
+	startTime = 0.0f;
+	endTime = 0.0f;
+	looping = true;
+}
+
+float DeltaClip::sample(Pose& outPose, float time, DeltaCursor* cursor) {
+	if (getDuration() == 0.0f || numValues == 0) {
+		return 0.0f;
+	}
+	time = adjustTimeToFitRange(time);
+	DeltaCursor localCursor;
+	if (cursor == 0) {
+		cursor = &localCursor;
+	}
+
+	float frameTime = (time - startTime) * frameRate;
+	unsigned int frame = frameTime > 0.0f ? (unsigned int)frameTime : 0;
+	if (frame >= numFrames - 1) {
+		seek(*cursor, numFrames - 1);
+		setPose(outPose, &cursor->values[0], &cursor->values[0], 0.0f);
+		return time;
+	}
+	// the cursor has to end in the next frame, with the frame in previousValues
+	if (cursor->frame != frame + 1 || !cursor->hasPrevious) {
+		seek(*cursor, frame);
+		advance(*cursor);
+	}
+	setPose(outPose, &cursor->previousValues[0], &cursor->values[0], frameTime - (float)frame);
+	return time;
+}
+
+void DeltaClip::seek(DeltaCursor& cursor, unsigned int frame) {
+	if (cursor.frame == frame) {
+		return;
+	}
+	unsigned int key = frame / keyInterval;
+	// the deltas can't be applied backwards, and a later key pose is closer than the frames in between
+	if (cursor.frame == DeltaCursor::NO_FRAME || frame < cursor.frame || key != cursor.frame / keyInterval) {
+		cursor.values.assign(keys.begin() + key * numValues, keys.begin() + (key + 1) * numValues);
+		cursor.previousValues.resize(numValues);
+		cursor.frame = key * keyInterval;
+		cursor.hasPrevious = false;
+		cursor.readOffset = deltaOffsets[key];
+	}
+	while (cursor.frame < frame) {
+		advance(cursor);
+	}
+}
+
+void DeltaClip::advance(DeltaCursor& cursor) {
+	unsigned int frame = cursor.frame + 1;
+	if (frame % keyInterval == 0) {
+		unsigned int key = frame / keyInterval;
+		std::copy(keys.begin() + key * numValues, keys.begin() + (key + 1) * numValues, cursor.previousValues.begin());
+		cursor.readOffset = deltaOffsets[key];
+	}
+	else {
+		const unsigned char* stream = &deltas[0];
+		for (unsigned int i = 0; i < numValues; ++i) {
+			cursor.previousValues[i] = cursor.values[i] + DeltaHelpers::readDelta(stream, cursor.readOffset);
+		}
+	}
+	cursor.values.swap(cursor.previousValues);
+	cursor.frame = frame;
+	cursor.hasPrevious = true;
+}
+
+void DeltaClip::setPose(Pose& outPose, const int* a, const int* b, float t) {
+	for (unsigned int i = 0, size = (unsigned int)tracks.size(); i < size; ++i) {
+		DeltaTrack& track = tracks[i];
+		// channels that aren't animated keep the value of the pose
+		Transform local = outPose.getLocalTransform(track.id);
+		if (track.position >= 0) {
+			const int* p0 = &a[track.position];
+			const int* p1 = &b[track.position];
+			local.position = lerp(vec3((float)p0[0], (float)p0[1], (float)p0[2]), vec3((float)p1[0], (float)p1[1], (float)p1[2]), t) * positionStep;
+		}
+		if (track.rotation >= 0) {
+			// the encoder keeps consecutive frames in the same neighborhood
+			const int* r0 = &a[track.rotation];
+			const int* r1 = &b[track.rotation];
+			quat q0((float)r0[0], (float)r0[1], (float)r0[2], (float)r0[3]);
+			quat q1((float)r1[0], (float)r1[1], (float)r1[2], (float)r1[3]);
+			local.rotation = nlerp(q0, q1, t);
+		}
+		if (track.scale >= 0) {
+			const int* s0 = &a[track.scale];
+			const int* s1 = &b[track.scale];
+			local.scale = lerp(vec3((float)s0[0], (float)s0[1], (float)s0[2]), vec3((float)s1[0], (float)s1[1], (float)s1[2]), t) * scaleStep;
+		}
+		outPose.setLocalTransform(track.id, local);
+	}
+}
+
+float DeltaClip::adjustTimeToFitRange(float inTime) {
+	float duration = endTime - startTime;
+	if (duration <= 0.0f) {
+		return startTime;
+	}
+	if (looping) {
+		inTime = fmodf(inTime - startTime, duration);
+		if (inTime < 0.0f) {
+			inTime += duration;
+		}
+		inTime = inTime + startTime;
+	}
+	else {
+		if (inTime < startTime) {
+			inTime = startTime;
+		}
+		if (inTime > endTime) {
+			inTime = endTime;
+		}
+	}
+	return inTime;
+}
+
+// getters
+unsigned int DeltaClip::size() {
+	return (unsigned int)tracks.size();
+}
+
+unsigned int DeltaClip::getIdAtIndex(unsigned int index) {
+	return tracks[index].id;
+}
+
+unsigned int DeltaClip::getNumFrames() {
+	return numFrames;
+}
+
+unsigned int DeltaClip::getKeyInterval() {
+	return keyInterval;
+}
+
+float DeltaClip::getFrameRate() {
+	return frameRate;
+}
+
+unsigned int DeltaClip::getByteSize() {
+	return (unsigned int)(keys.size() * sizeof(int) + deltas.size() + deltaOffsets.size() * sizeof(unsigned int) + tracks.size() * sizeof(DeltaTrack));
+}
+
+std::string& DeltaClip::getName() {
+	return name;
+}
+
+float DeltaClip::getDuration() {
+	return endTime - startTime;
+}
+
+float DeltaClip::getStartTime() {
+	return startTime;
+}
+
+float DeltaClip::getEndTime() {
+	return endTime;
+}
+
+bool DeltaClip::getLooping() {
+	return looping;
+}
+
+// setters
+void DeltaClip::setLooping(bool inLooping) {
+	looping = inLooping;
+}
+
+DeltaClip encodeDeltaClip(Clip& input, const DeltaClipSettings& settings) {
+	DeltaClip result;
+	result.name = input.getName();
+	result.looping = input.getLooping();
+	result.startTime = input.getStartTime();
+	result.endTime = input.getEndTime();
+	result.keyInterval = settings.keyInterval > 0 ? settings.keyInterval : 1;
+	result.positionStep = settings.positionStep;
+	result.scaleStep = settings.scaleStep;
+
+	// channel layout of the frames
+	float frameRate = settings.frameRate;
+	for (unsigned int i = 0, size = input.size(); i < size; ++i) {
+		TransformTrack& inputTrack = *input.findTrack(input.getIdAtIndex(i));
+		DeltaTrack track;
+		track.id = inputTrack.getId();
+		if (inputTrack.getPositionTrack().size() > 0) {
+			track.position = (int)result.numValues;
+			result.numValues += 3;
+		}
+		if (inputTrack.getRotationTrack().size() > 0) {
+			track.rotation = (int)result.numValues;
+			result.numValues += 4;
+		}
+		if (inputTrack.getScaleTrack().size() > 0) {
+			track.scale = (int)result.numValues;
+			result.numValues += 3;
+		}
+		result.tracks.push_back(track);
+		if (settings.frameRate <= 0.0f) {
+			frameRate = fmaxf(frameRate, DeltaHelpers::keyRate(inputTrack.getPositionTrack()));
+			frameRate = fmaxf(frameRate, DeltaHelpers::keyRate(inputTrack.getRotationTrack()));
+			frameRate = fmaxf(frameRate, DeltaHelpers::keyRate(inputTrack.getScaleTrack()));
+		}
+	}
+	float duration = result.getDuration();
+	if (duration <= 0.0f || frameRate <= 0.0f) {
+		// a single pose
+		frameRate = 1.0f;
+		result.numFrames = 1;
+	}
+	else {
+		// the tolerance avoids an extra frame when the duration is a whole number of frames
+		result.numFrames = (unsigned int)ceilf(duration * frameRate - 0.01f) + 1;
+		// spreads the frames evenly over the duration, so that the last frame is at the end time where sample expects it
+		frameRate = (float)(result.numFrames - 1) / duration;
+	}
+	result.frameRate = frameRate;
+
+	std::vector<int> values(result.numValues);
+	std::vector<int> previousValues(result.numValues);
+	for (unsigned int f = 0; f < result.numFrames; ++f) {
+		float time = fminf(result.startTime + (float)f / frameRate, result.endTime);
+		for (unsigned int i = 0, size = (unsigned int)result.tracks.size(); i < size; ++i) {
+			DeltaTrack& track = result.tracks[i];
+			TransformTrack& inputTrack = *input.findTrack(track.id);
+			if (track.position >= 0) {
+				vec3 position = inputTrack.getPositionTrack().sample(time, false);
+				for (int j = 0; j < 3; ++j) {
+					values[track.position + j] = DeltaHelpers::quantize(position.v[j], settings.positionStep);
+				}
+			}
+			if (track.rotation >= 0) {
+				quat rotation = normalized(inputTrack.getRotationTrack().sample(time, false));
+				// same neighborhood as the previous frame, so that the deltas are small and the frames can be interpolated
+				if (f > 0) {
+					const int* previous = &previousValues[track.rotation];
+					if (rotation.x * previous[0] + rotation.y * previous[1] + rotation.z * previous[2] + rotation.w * previous[3] < 0.0f) {
+						rotation = -rotation;
+					}
+				}
+				for (int j = 0; j < 4; ++j) {
+					values[track.rotation + j] = DeltaHelpers::quantize(rotation.v[j], settings.rotationStep);
+				}
+			}
+			if (track.scale >= 0) {
+				vec3 scale = inputTrack.getScaleTrack().sample(time, false);
+				for (int j = 0; j < 3; ++j) {
+					values[track.scale + j] = DeltaHelpers::quantize(scale.v[j], settings.scaleStep);
+				}
+			}
+		}
+
+		if (f % result.keyInterval == 0) {
+			result.keys.insert(result.keys.end(), values.begin(), values.end());
+			result.deltaOffsets.push_back((unsigned int)result.deltas.size());
+		}
+		else {
+			for (unsigned int i = 0; i < result.numValues; ++i) {
+				DeltaHelpers::writeDelta(result.deltas, values[i] - previousValues[i]);
+			}
+		}
+		values.swap(previousValues);
+	}
+	return result;
+}
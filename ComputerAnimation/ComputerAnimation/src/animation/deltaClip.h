@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <string>
+#include "clip.h"
+#include "pose.h"
+
+// Settings of encodeDeltaClip
+struct DeltaClipSettings {
+	unsigned int keyInterval; // frames between two key poses
+	float frameRate; // frames per second (rounded to fit a whole number of frames in the clip), 0 uses the highest key rate of the tracks
+	// quantization step of the values (positions and scales are in the units of the skeleton)
+	float positionStep;
+	float rotationStep;
+	float scaleStep;
+
+	inline DeltaClipSettings() : keyInterval(30), frameRate(0.0f), positionStep(0.001f), rotationStep(0.00005f), scaleStep(0.0001f) { }
+};
+
+// indices of the values of the channels of a joint in the frames of a DeltaClip, -1 if the channel isn't animated
+struct DeltaTrack {
+	unsigned int id; // joint Id
+	int position;
+	int rotation;
+	int scale;
+
+	inline DeltaTrack() : id(0), position(-1), rotation(-1), scale(-1) { }
+};
+
+// Playback state of a DeltaClip: the last two decoded frames, so that sequential playback only applies the deltas of the
+// new frames. Each character playing a delta clip keeps its own cursor.
+class DeltaCursor {
+protected:
+	std::vector<int> values; // quantized values of the decoded frame
+	std::vector<int> previousValues; // quantized values of the frame before it
+	unsigned int frame; // decoded frame, or NO_FRAME
+	bool hasPrevious; // false after a jump to a key pose
+	unsigned int readOffset; // position of the deltas of the next frame
+public:
+	static const unsigned int NO_FRAME = 0xFFFFFFFF;
+
+	inline DeltaCursor() : frame(NO_FRAME), hasPrevious(false), readOffset(0) { }
+	// forget the decoded frames (after jumping to another clip, for example)
+	void reset();
+
+	friend class DeltaClip;
+};
+
+// Clip for very long takes, encoded like a video: a full key pose every keyInterval frames, and the frames in between
+// as the quantized differences to the previous frame. The values are quantized before taking the differences, so
+// decoding them is exact and the error doesn't grow along the take.
+// Sampling seeks the key pose before the time and applies the deltas forward (only the new frames with a cursor).
+class DeltaClip {
+protected:
+	std::vector<DeltaTrack> tracks;
+	std::vector<int> keys; // quantized values of the key poses
+	std::vector<unsigned char> deltas; // variable length differences of the frames between the key poses
+	std::vector<unsigned int> deltaOffsets; // position in deltas of the first frame after each key pose
+	unsigned int numValues; // values of a frame
+	unsigned int numFrames;
+	unsigned int keyInterval;
+	float frameRate;
+	float positionStep;
+	float scaleStep; // the rotations are normalized, so their step isn't needed to decode them
+	std::string name;
+	float startTime;
+	float endTime;
+	bool looping;
+
+protected:
+	float adjustTimeToFitRange(float inTime);
+	// moves the cursor to the frame, decoding the frames after the closest key pose
+	void seek(DeltaCursor& cursor, unsigned int frame);
+	// decodes the frame after the frame of the cursor
+	void advance(DeltaCursor& cursor);
+	// writes the interpolation of two decoded frames into the pose
+	void setPose(Pose& outPose, const int* a, const int* b, float t);
+
+public:
+	DeltaClip();
+
+	//samples the animation clip at the provided time into the Pose reference (the cursor is optional)
+	float sample(Pose& outPose, float inTime, DeltaCursor* cursor = 0);
+
+	unsigned int size();
+	unsigned int getIdAtIndex(unsigned int index);
+	unsigned int getNumFrames();
+	unsigned int getKeyInterval();
+	float getFrameRate();
+	// bytes used by the key poses, the deltas and the tracks of the clip
+	unsigned int getByteSize();
+
+	std::string& getName();
+	float getDuration();
+	float getStartTime();
+	float getEndTime();
+	bool getLooping();
+	void setLooping(bool inLooping);
+
+	friend DeltaClip encodeDeltaClip(Clip& input, const DeltaClipSettings& settings);
+};
+
+// samples the clip at a uniform frame rate and encodes the frames as key poses and deltas (to be done once, after loading
+// the clip)
+DeltaClip encodeDeltaClip(Clip& input, const DeltaClipSettings& settings = DeltaClipSettings());
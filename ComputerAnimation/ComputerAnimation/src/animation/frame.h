@@ -1,5 +1,7 @@
 #pragma once
 
+// Single keyframe, used to build tracks and read their frames back.
+// Tracks don't store frames: they keep the times, the values and the tangents in separate arrays.
 template<unsigned int N>
 class Frame {
 public:
@@ -7,6 +9,14 @@ public:
 	float in[N]; //in tangent
 	float out[N]; //out tangent
 	float time; //frame time
+
+	inline Frame() : time(0.0f) {
+		for (unsigned int i = 0; i < N; ++i) {
+			value[i] = 0.0f;
+			in[i] = 0.0f;
+			out[i] = 0.0f;
+		}
+	}
 };
 
 typedef Frame<1> ScalarFrame;
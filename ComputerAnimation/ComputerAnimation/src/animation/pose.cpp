@@ -1,9 +1,14 @@
 #include "pose.h"
 #include <iostream>
 
-Pose::Pose() { }
+Pose::Pose() {
+	cacheEnabled = false;
+	childrenDirty = true;
+}
 
 Pose::Pose(unsigned int numJoints) {
+	cacheEnabled = false;
+	childrenDirty = true;
 	resize(numJoints);
 }
 
@@ -16,6 +21,11 @@ void Pose::resize(unsigned int size) {
 	// TO DO:
 	joints.resize(size);
 	parents.resize(size);
+	if (cacheEnabled) {
+		globalCache.resize(size);
+		dirty.assign(size, true);
+		childrenDirty = true;
+	}
 }
 
 // get the number of joints
@@ -28,6 +38,10 @@ unsigned int Pose::size() {
 void Pose::setParent(unsigned int id, unsigned int parentId) {
 	// TO DO:
 	parents[id] = parentId;
+	if (cacheEnabled) {
+		childrenDirty = true;
+		markAllDirty();
+	}
 }
 
 // get parent id
@@ -40,6 +54,9 @@ int Pose::getParent(unsigned int id) {
 void Pose::setLocalTransform(unsigned int id, const Transform& transform) {
 	//TO DO:
 	joints[id] = transform;
+	if (cacheEnabled) {
+		markDirty(id);
+	}
 }
 
 // get local transform of the joint
@@ -48,9 +65,19 @@ Transform Pose::getLocalTransform(unsigned int id) {
 	return joints[id];
 }
 
+Transform* Pose::getLocalTransforms() {
+	if (cacheEnabled) {
+		markAllDirty();
+	}
+	return &joints[0];
+}
+
 
 // get global (world) transform of the joint
 Transform Pose::getGlobalTransform(unsigned int id) {
+	if (cacheEnabled) {
+		return getCachedGlobalTransform(id);
+	}
 	// TO DO: use "combine()" function to combine two transforms
 	Transform globalTransform = joints[id];
 	
@@ -64,19 +91,151 @@ Transform Pose::getGlobalTransform(unsigned int id) {
 
 // get global matrices of the joints
 std::vector<mat4> Pose::getGlobalMatrices() {
+	std::vector<mat4> out;
+	getGlobalMatrices(out);
+	return out;
+}
+
+void Pose::getGlobalMatrices(std::vector<mat4>& out) {
+	getGlobalTransforms(globals);
 	unsigned int numJoints = size();
-	std::vector<mat4> out(numJoints);
+	out.resize(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		out[i] = transformToMat4(globals[i]);
+	}
+}
 
-    Transform globalTransform;
-    mat4 globalTransformMatrix;
+// The transforms are combined before converting them, so a scale in the hierarchy cancels out with the one of the inverse
+// bind pose instead of being dropped from both
+void Pose::getDualQuaternionPalette(std::vector<dualquat>& out, std::vector<Transform>& invBindPose) {
+	getGlobalTransforms(globals);
+	unsigned int numJoints = size();
+	out.resize(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		out[i] = transformToDualQuat(combine(globals[i], invBindPose[i]));
+	}
+}
 
-	// TO DO: For every joint, find the global transform (using getGlobalTransform), convert it into a matrix, and store the result in a vector of matrices
-	for (unsigned int i = 0; i < numJoints; ++i) 
-	{
-		globalTransform = getGlobalTransform(i);
-		globalTransformMatrix = transformToMat4(globalTransform);
-		out[i] = globalTransformMatrix;
+// Only the 3 rows of the product that are packed are computed, the last rows of both matrices are (0, 0, 0, 1)
+void Pose::getPackedPalette(std::vector<mat3x4>& out, std::vector<mat4>& invBindPose) {
+	getGlobalTransforms(globals);
+	unsigned int numJoints = size();
+	out.resize(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		mat4 global = transformToMat4(globals[i]);
+		const float* b = invBindPose[i].v;
+		float* packed = out[i].v;
+		for (int r = 0; r < 3; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				// column c of the inverse bind pose times row r of the global matrix (column-major mat4)
+				packed[r * 4 + c] = global.v[r] * b[c * 4] + global.v[4 + r] * b[c * 4 + 1] +
+					global.v[8 + r] * b[c * 4 + 2] + global.v[12 + r] * b[c * 4 + 3];
+			}
+		}
 	}
+}
 
-	return out;
+// Fast path: the parents come before their children (the usual order of the skeletons), so the global transform of the
+// parent is always ready
+void Pose::getGlobalTransforms(std::vector<Transform>& out) {
+	unsigned int numJoints = size();
+	out.resize(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		int parent = parents[i];
+		if (parent >= (int)i) {
+			getUnorderedGlobalTransforms(out, i);
+			return;
+		}
+		out[i] = parent < 0 ? joints[i] : combine(out[parent], joints[i]);
+	}
+	if (cacheEnabled) {
+		globalCache = out;
+		dirty.assign(numJoints, false);
+	}
+}
+
+// Fallback: the chain of parents of each joint is walked up to the first joint already computed, and then computed down
+void Pose::getUnorderedGlobalTransforms(std::vector<Transform>& out, unsigned int first) {
+	unsigned int numJoints = size();
+	std::vector<bool> computed(numJoints, false);
+	for (unsigned int i = 0; i < first; ++i) {
+		computed[i] = true;
+	}
+	std::vector<unsigned int> chain;
+	for (unsigned int i = first; i < numJoints; ++i) {
+		for (int joint = (int)i; joint >= 0 && !computed[joint]; joint = parents[joint]) {
+			chain.push_back(joint);
+		}
+		while (!chain.empty()) {
+			unsigned int joint = chain.back();
+			chain.pop_back();
+			int parent = parents[joint];
+			out[joint] = parent < 0 ? joints[joint] : combine(out[parent], joints[joint]);
+			computed[joint] = true;
+		}
+	}
+	if (cacheEnabled) {
+		globalCache = out;
+		dirty.assign(numJoints, false);
+	}
+}
+
+void Pose::setGlobalCacheEnabled(bool enabled) {
+	cacheEnabled = enabled;
+	if (enabled) {
+		globalCache.resize(size());
+		dirty.assign(size(), true);
+		childrenDirty = true;
+	}
+	else {
+		globalCache.clear();
+		dirty.clear();
+		children.clear();
+	}
+}
+
+bool Pose::isGlobalCacheEnabled() {
+	return cacheEnabled;
+}
+
+void Pose::markDirty(unsigned int id) {
+	if (dirty[id]) {
+		return;
+	}
+	if (childrenDirty) {
+		unsigned int numJoints = size();
+		children.assign(numJoints, std::vector<unsigned int>());
+		for (unsigned int i = 0; i < numJoints; ++i) {
+			if (parents[i] >= 0) {
+				children[parents[i]].push_back(i);
+			}
+		}
+		childrenDirty = false;
+	}
+	dirty[id] = true;
+	for (unsigned int i = 0, numChildren = (unsigned int)children[id].size(); i < numChildren; ++i) {
+		markDirty(children[id][i]);
+	}
+}
+
+void Pose::markAllDirty() {
+	dirty.assign(size(), true);
+}
+
+const Transform& Pose::getCachedGlobalTransform(unsigned int id) {
+	if (dirty[id]) {
+		int parent = parents[id];
+		globalCache[id] = parent < 0 ? joints[id] : combine(getCachedGlobalTransform(parent), joints[id]);
+		dirty[id] = false;
+	}
+	return globalCache[id];
+}
+
+bool Pose::isTopologicallyOrdered() {
+	for (unsigned int i = 0, numJoints = size(); i < numJoints; ++i) {
+		if (parents[i] >= (int)i) {
+			return false;
+		}
+	}
+	return true;
 }
\ No newline at end of file
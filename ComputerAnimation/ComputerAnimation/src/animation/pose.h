@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include "../math/transform.h"
+#include "../math/dualquat.h"
+#include "../math/mat3x4.h"
 
 // Used to hold the transformation of every bone in an animated hierarchy
 class Pose
@@ -8,6 +10,22 @@ class Pose
 protected:
 	std::vector<Transform> joints; // local transforms
 	std::vector<int> parents; // parent joints Id (index in the joints array)
+	std::vector<Transform> globals; // buffer of getGlobalMatrices, kept to avoid allocating it every frame
+	// optional cache of the global transforms: a dirty joint has to be recomputed, and so does its subtree
+	std::vector<Transform> globalCache;
+	std::vector<bool> dirty;
+	std::vector<std::vector<unsigned int> > children; // children of every joint, to mark the subtrees
+	bool cacheEnabled;
+	bool childrenDirty; // the children are rebuilt after changing the parents
+
+protected:
+	// global transforms of the joints from the first one, when a parent comes after its child
+	void getUnorderedGlobalTransforms(std::vector<Transform>& out, unsigned int first);
+	// marks the joint and its subtree dirty (the subtree of a dirty joint is already dirty)
+	void markDirty(unsigned int id);
+	void markAllDirty();
+	// cached global transform of the joint, the dirty parents are computed first
+	const Transform& getCachedGlobalTransform(unsigned int id);
 public:
 	
 	Pose(); // Empty constructor
@@ -28,9 +46,29 @@ public:
 	void setLocalTransform(unsigned int id, const Transform& transform);
 	// Get the transformation of the joint given its id
 	Transform getLocalTransform(unsigned int id);
+	// Direct access to the local transforms of all the joints (used to write batches of sampled transforms)
+	Transform* getLocalTransforms();
 	// Get the global transformation (world space) of the joint 
 	Transform getGlobalTransform(unsigned int id);
+	// With the cache of global transforms, getGlobalTransform only combines the joints changed since the last call, which
+	// helps the code that reads and edits a few joints many times per frame (IK, gaze, retargeting, debug draw).
+	// getLocalTransforms marks every joint dirty, since the transforms can be written through the pointer
+	void setGlobalCacheEnabled(bool enabled);
+	bool isGlobalCacheEnabled();
 	// Get the global transformation matrix (world space) of all the joints
 	std::vector<mat4> getGlobalMatrices();
+	// Global transforms and matrices of all the joints in a single pass, written into the given vectors (resized if needed).
+	// Each joint combines the global transform of its parent, so the cost is linear when the parents come before their children.
+	void getGlobalTransforms(std::vector<Transform>& out);
+	void getGlobalMatrices(std::vector<mat4>& out);
+	// Skin transforms of the joints as dual quaternions (global transform combined with the inverse bind pose), for the
+	// dual quaternion skinning. Dual quaternions only hold a rotation and a translation: a uniform scale that is the same in
+	// the bind pose and in the pose cancels in the combination, any other scale (animated or non-uniform) is dropped
+	void getDualQuaternionPalette(std::vector<dualquat>& out, std::vector<Transform>& invBindPose);
+	// Skin matrices of the joints (global matrix * inverse bind pose) without their last row, for the skinning shaders
+	// that read a mat3x4 palette (skinned_3x4.vs and morph_3x4.vs)
+	void getPackedPalette(std::vector<mat3x4>& out, std::vector<mat4>& invBindPose);
+	// true if every parent comes before its children
+	bool isTopologicallyOrdered();
 };
 
@@ -9,6 +9,8 @@ Skeleton::Skeleton(const Pose& rest, const Pose& bind, const std::vector<std::st
 void Skeleton::set(const Pose& rest, const Pose& bind, const std::vector<std::string>& names) {
 	restPose = rest;
 	bindPose = bind;
+	// the bind pose rarely changes, and its global transforms are read joint by joint (inverse bind pose, retargeting)
+	bindPose.setGlobalCacheEnabled(true);
 	jointNames = names;
 	// TODO: any time the bind pose of the skeleton is updated, the inverse bind pose should be re - calculated as well.
 	updateInvBindPose();
@@ -28,6 +30,21 @@ std::vector<mat4>& Skeleton::getInvBindPose() {
 	return invBindPose;
 }
 
+void Skeleton::getSkinPalette(Pose& pose, std::vector<mat4>& out) {
+	pose.getGlobalMatrices(out);
+	for (unsigned int i = 0, numJoints = (unsigned int)out.size(); i < numJoints; ++i) {
+		out[i] = out[i] * invBindPose[i];
+	}
+}
+
+void Skeleton::getSkinPalette(Pose& pose, std::vector<mat3x4>& out) {
+	pose.getPackedPalette(out, invBindPose);
+}
+
+void Skeleton::getDualQuaternionPalette(Pose& pose, std::vector<dualquat>& out) {
+	pose.getDualQuaternionPalette(out, invBindTransforms);
+}
+
 std::vector<std::string>& Skeleton::getJointNames() {
 	return jointNames;
 }
@@ -41,11 +58,13 @@ void Skeleton::updateInvBindPose() {
 	// TO DO: Get the world space transform of each joint, convert it into a matrix and invert it, then update the inverse bind pose matrix of the joint 
 	unsigned int numJoints = bindPose.size();
 	invBindPose.resize(numJoints);
+	invBindTransforms.resize(numJoints);
 
 	for (unsigned int i = 0; i < numJoints; ++i) 
 	{
 		Transform worldTransform = bindPose.getGlobalTransform(i);
 		mat4 invBindPoseMatrix = inverse(transformToMat4(worldTransform));
 		invBindPose[i] = invBindPoseMatrix;
+		invBindTransforms[i] = inverse(worldTransform);
 	}
 }
\ No newline at end of file
@@ -9,6 +9,7 @@ protected:
 	Pose restPose;
 	
 	std::vector<mat4> invBindPose; // vector of inverse bind pose matrix of each joint
+	std::vector<Transform> invBindTransforms; // the same inverse bind poses as transforms, for the dual quaternion palette
 	std::vector<std::string> jointNames; // vector of the name of each joint
 
 	// updates the inverse bind pose matrices: any time the bind pose of the skeleton is updated, the inverse bind pose should be re-calculated as well
@@ -25,6 +26,13 @@ public:
 	Pose& getRestPose();
 
 	std::vector<mat4>& getInvBindPose();
+	// skin matrices of the joints (global matrix of the pose * inverse bind pose), computed once per joint for all the
+	// vertices. The CPU skinning and the skinning shaders use the same palette
+	void getSkinPalette(Pose& pose, std::vector<mat4>& out);
+	// the same skin matrices packed in 12 floats (Uniform<mat3x4>), 25% less data to upload every frame
+	void getSkinPalette(Pose& pose, std::vector<mat3x4>& out);
+	// skin transforms of the joints as dual quaternions, 8 floats per joint (Mesh::CPUSkin and skinned_dq.vs)
+	void getDualQuaternionPalette(Pose& pose, std::vector<dualquat>& out);
 	std::vector<std::string>& getJointNames();
 	std::string& getJointName(unsigned int id);
 };
\ No newline at end of file
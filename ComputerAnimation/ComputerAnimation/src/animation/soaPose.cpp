@@ -0,0 +1,374 @@
+#include "soaPose.h"
+#include <cstring>
+#include <algorithm>
+#include <emmintrin.h>
+
+// SSE kernels of the SoA pose: one register holds a component of 4 joints, and the operations are the same as the
+// scalar combine() and transformToMat4() of the transforms
+namespace SoAHelpers {
+
+	// first 16 byte aligned value of the data (the vectors have 3 values more than needed)
+	inline float* aligned(std::vector<float>& data) {
+		return (float*)(((size_t)&data[0] + 15) & ~(size_t)15);
+	}
+
+	inline const float* aligned(const std::vector<float>& data) {
+		return (const float*)(((size_t)&data[0] + 15) & ~(size_t)15);
+	}
+
+	inline __m128 gather(const float* stream, const unsigned int* ids) {
+		return _mm_set_ps(stream[ids[3]], stream[ids[2]], stream[ids[1]], stream[ids[0]]);
+	}
+
+	// q * v of 4 quaternions and vectors, like the quat * vec3 operator
+	inline void rotate(__m128 qx, __m128 qy, __m128 qz, __m128 qw, __m128 vx, __m128 vy, __m128 vz, __m128& outX, __m128& outY, __m128& outZ) {
+		__m128 two = _mm_set1_ps(2.0f);
+		__m128 dotQV = _mm_mul_ps(two, _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, vx), _mm_mul_ps(qy, vy)), _mm_mul_ps(qz, vz)));
+		__m128 dotQQ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz));
+		__m128 s = _mm_sub_ps(_mm_mul_ps(qw, qw), dotQQ);
+		__m128 w2 = _mm_mul_ps(two, qw);
+		// q.vector * 2 * dot(q.vector, v) + v * (w^2 - dot(q.vector, q.vector)) + cross(q.vector, v) * 2 * w
+		outX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, dotQV), _mm_mul_ps(vx, s)), _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)), w2));
+		outY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qy, dotQV), _mm_mul_ps(vy, s)), _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)), w2));
+		outZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qz, dotQV), _mm_mul_ps(vz, s)), _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)), w2));
+	}
+
+	// combine(parent, child) of 4 joints, the components are indexed with the streams of the pose
+	inline void combine(const __m128* parent, const __m128* child, __m128* out) {
+		out[SoAPose::SCALE_X] = _mm_mul_ps(parent[SoAPose::SCALE_X], child[SoAPose::SCALE_X]);
+		out[SoAPose::SCALE_Y] = _mm_mul_ps(parent[SoAPose::SCALE_Y], child[SoAPose::SCALE_Y]);
+		out[SoAPose::SCALE_Z] = _mm_mul_ps(parent[SoAPose::SCALE_Z], child[SoAPose::SCALE_Z]);
+
+		// child rotation * parent rotation
+		__m128 ax = child[SoAPose::ROTATION_X], ay = child[SoAPose::ROTATION_Y], az = child[SoAPose::ROTATION_Z], aw = child[SoAPose::ROTATION_W];
+		__m128 bx = parent[SoAPose::ROTATION_X], by = parent[SoAPose::ROTATION_Y], bz = parent[SoAPose::ROTATION_Z], bw = parent[SoAPose::ROTATION_W];
+		out[SoAPose::ROTATION_X] = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(bx, aw), _mm_mul_ps(by, az)), _mm_mul_ps(bz, ay)), _mm_mul_ps(bw, ax));
+		out[SoAPose::ROTATION_Y] = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(by, aw), _mm_mul_ps(bx, az)), _mm_mul_ps(bz, ax)), _mm_mul_ps(bw, ay));
+		out[SoAPose::ROTATION_Z] = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(bx, ay), _mm_mul_ps(by, ax)), _mm_mul_ps(bz, aw)), _mm_mul_ps(bw, az));
+		out[SoAPose::ROTATION_W] = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(bw, aw), _mm_mul_ps(bx, ax)), _mm_mul_ps(by, ay)), _mm_mul_ps(bz, az));
+
+		// parent position + parent rotation * (parent scale * child position)
+		__m128 x, y, z;
+		rotate(bx, by, bz, bw,
+			_mm_mul_ps(parent[SoAPose::SCALE_X], child[SoAPose::POSITION_X]),
+			_mm_mul_ps(parent[SoAPose::SCALE_Y], child[SoAPose::POSITION_Y]),
+			_mm_mul_ps(parent[SoAPose::SCALE_Z], child[SoAPose::POSITION_Z]), x, y, z);
+		out[SoAPose::POSITION_X] = _mm_add_ps(parent[SoAPose::POSITION_X], x);
+		out[SoAPose::POSITION_Y] = _mm_add_ps(parent[SoAPose::POSITION_Y], y);
+		out[SoAPose::POSITION_Z] = _mm_add_ps(parent[SoAPose::POSITION_Z], z);
+	}
+
+	// columns of the matrices of 4 transforms, like transformToMat4: rotated and scaled basis, and position.
+	// columns[c] has the column c of the 4 joints, transposed so that columns[j * 4 + c] is the column c of the joint j
+	inline void matrices(const float* const* streams, unsigned int first, __m128* columns) {
+		__m128 qx = _mm_load_ps(streams[SoAPose::ROTATION_X] + first);
+		__m128 qy = _mm_load_ps(streams[SoAPose::ROTATION_Y] + first);
+		__m128 qz = _mm_load_ps(streams[SoAPose::ROTATION_Z] + first);
+		__m128 qw = _mm_load_ps(streams[SoAPose::ROTATION_W] + first);
+		__m128 zero = _mm_setzero_ps();
+		__m128 one = _mm_set1_ps(1.0f);
+
+		__m128 x[4], y[4], z[4], p[4];
+		rotate(qx, qy, qz, qw, one, zero, zero, x[0], x[1], x[2]);
+		rotate(qx, qy, qz, qw, zero, one, zero, y[0], y[1], y[2]);
+		rotate(qx, qy, qz, qw, zero, zero, one, z[0], z[1], z[2]);
+		__m128 sx = _mm_load_ps(streams[SoAPose::SCALE_X] + first);
+		__m128 sy = _mm_load_ps(streams[SoAPose::SCALE_Y] + first);
+		__m128 sz = _mm_load_ps(streams[SoAPose::SCALE_Z] + first);
+		for (int c = 0; c < 3; ++c) {
+			x[c] = _mm_mul_ps(x[c], sx);
+			y[c] = _mm_mul_ps(y[c], sy);
+			z[c] = _mm_mul_ps(z[c], sz);
+		}
+		x[3] = zero;
+		y[3] = zero;
+		z[3] = zero;
+		p[0] = _mm_load_ps(streams[SoAPose::POSITION_X] + first);
+		p[1] = _mm_load_ps(streams[SoAPose::POSITION_Y] + first);
+		p[2] = _mm_load_ps(streams[SoAPose::POSITION_Z] + first);
+		p[3] = one;
+
+		// SoA to AoS: after the transpose, x[j] is the first column of the joint j
+		_MM_TRANSPOSE4_PS(x[0], x[1], x[2], x[3]);
+		_MM_TRANSPOSE4_PS(y[0], y[1], y[2], y[3]);
+		_MM_TRANSPOSE4_PS(z[0], z[1], z[2], z[3]);
+		_MM_TRANSPOSE4_PS(p[0], p[1], p[2], p[3]);
+		for (int j = 0; j < 4; ++j) {
+			columns[j * 4 + 0] = x[j];
+			columns[j * 4 + 1] = y[j];
+			columns[j * 4 + 2] = z[j];
+			columns[j * 4 + 3] = p[j];
+		}
+	}
+
+	// a * b, where a is given by its columns
+	inline void multiply(const __m128* a, const mat4& b, float* out) {
+		for (int c = 0; c < 4; ++c) {
+			const float* column = &b.v[c * 4];
+			__m128 r = _mm_mul_ps(a[0], _mm_set1_ps(column[0]));
+			r = _mm_add_ps(r, _mm_mul_ps(a[1], _mm_set1_ps(column[1])));
+			r = _mm_add_ps(r, _mm_mul_ps(a[2], _mm_set1_ps(column[2])));
+			r = _mm_add_ps(r, _mm_mul_ps(a[3], _mm_set1_ps(column[3])));
+			_mm_storeu_ps(out + c * 4, r);
+		}
+	}
+}; // End SoA helpers namespace
+
+SoAPose::SoAPose() {
+	numJoints = 0;
+	stride = 0;
+	batchesDirty = false;
+	resize(0);
+}
+
+SoAPose::SoAPose(const SoAPose& p) {
+	*this = p;
+}
+
+SoAPose& SoAPose::operator=(const SoAPose& p) {
+	if (this == &p) {
+		return *this;
+	}
+	numJoints = p.numJoints;
+	stride = p.stride;
+	parents = p.parents;
+	batches = p.batches;
+	batchesDirty = p.batchesDirty;
+	// the copies of the vectors can have another alignment
+	locals.resize(p.locals.size());
+	globals.resize(p.globals.size());
+	memcpy(SoAHelpers::aligned(locals), SoAHelpers::aligned(p.locals), NUM_STREAMS * stride * sizeof(float));
+	memcpy(SoAHelpers::aligned(globals), SoAHelpers::aligned(p.globals), NUM_STREAMS * stride * sizeof(float));
+	return *this;
+}
+
+SoAPose::SoAPose(Pose& pose) {
+	numJoints = 0;
+	stride = 0;
+	batchesDirty = false;
+	resize(pose.size());
+	fromPose(pose);
+}
+
+void SoAPose::resize(unsigned int size) {
+	numJoints = size;
+	// one more slot for the identity parent of the roots, rounded up to a multiple of 4 joints
+	stride = (size + 1 + 3) & ~3u;
+	parents.resize(size, -1);
+	locals.assign(NUM_STREAMS * stride + 3, 0.0f);
+	globals.assign(NUM_STREAMS * stride + 3, 0.0f);
+	// identity transforms
+	const Stream ones[] = { ROTATION_W, SCALE_X, SCALE_Y, SCALE_Z };
+	for (int i = 0; i < 4; ++i) {
+		std::fill(getLocalStream(ones[i]), getLocalStream(ones[i]) + stride, 1.0f);
+		std::fill(getGlobalStream(ones[i]), getGlobalStream(ones[i]) + stride, 1.0f);
+	}
+	batchesDirty = true;
+}
+
+unsigned int SoAPose::size() {
+	return numJoints;
+}
+
+void SoAPose::setParent(unsigned int id, int parentId) {
+	parents[id] = parentId;
+	batchesDirty = true;
+}
+
+int SoAPose::getParent(unsigned int id) {
+	return parents[id];
+}
+
+void SoAPose::setLocalTransform(unsigned int id, const Transform& transform) {
+	float* data = SoAHelpers::aligned(locals);
+	data[POSITION_X * stride + id] = transform.position.x;
+	data[POSITION_Y * stride + id] = transform.position.y;
+	data[POSITION_Z * stride + id] = transform.position.z;
+	data[ROTATION_X * stride + id] = transform.rotation.x;
+	data[ROTATION_Y * stride + id] = transform.rotation.y;
+	data[ROTATION_Z * stride + id] = transform.rotation.z;
+	data[ROTATION_W * stride + id] = transform.rotation.w;
+	data[SCALE_X * stride + id] = transform.scale.x;
+	data[SCALE_Y * stride + id] = transform.scale.y;
+	data[SCALE_Z * stride + id] = transform.scale.z;
+}
+
+Transform SoAPose::getLocalTransform(unsigned int id) {
+	float* data = SoAHelpers::aligned(locals);
+	Transform result;
+	result.position = vec3(data[POSITION_X * stride + id], data[POSITION_Y * stride + id], data[POSITION_Z * stride + id]);
+	result.rotation = quat(data[ROTATION_X * stride + id], data[ROTATION_Y * stride + id], data[ROTATION_Z * stride + id], data[ROTATION_W * stride + id]);
+	result.scale = vec3(data[SCALE_X * stride + id], data[SCALE_Y * stride + id], data[SCALE_Z * stride + id]);
+	return result;
+}
+
+float* SoAPose::getLocalStream(Stream stream) {
+	return SoAHelpers::aligned(locals) + stream * stride;
+}
+
+float* SoAPose::getGlobalStream(Stream stream) {
+	return SoAHelpers::aligned(globals) + stream * stride;
+}
+
+void SoAPose::fromPose(Pose& pose) {
+	unsigned int poseSize = pose.size();
+	if (poseSize != numJoints) {
+		resize(poseSize);
+	}
+	for (unsigned int i = 0; i < poseSize; ++i) {
+		if (parents[i] != pose.getParent(i)) {
+			setParent(i, pose.getParent(i));
+		}
+	}
+	if (poseSize == 0) {
+		return;
+	}
+	const Transform* transforms = pose.getLocalTransforms();
+	for (unsigned int i = 0; i < poseSize; ++i) {
+		setLocalTransform(i, transforms[i]);
+	}
+}
+
+void SoAPose::toPose(Pose& outPose) {
+	if (outPose.size() != numJoints) {
+		outPose.resize(numJoints);
+	}
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		outPose.setParent(i, parents[i]);
+		outPose.setLocalTransform(i, getLocalTransform(i));
+	}
+}
+
+void SoAPose::updateBatches() {
+	batches.clear();
+	batchesDirty = false;
+	if (numJoints == 0) {
+		return;
+	}
+
+	// depth of every joint (the parents can come after their children)
+	std::vector<int> depths(numJoints, -1);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		int depth = 0;
+		for (int p = parents[i]; p >= 0; p = parents[p]) {
+			if (depths[p] >= 0) {
+				depth += depths[p] + 1;
+				break;
+			}
+			++depth;
+		}
+		depths[i] = depth;
+	}
+	std::vector<unsigned int> order(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&depths](unsigned int a, unsigned int b) { return depths[a] < depths[b]; });
+
+	// a joint starts a new group when its parent is in the current group
+	std::vector<bool> inGroup(numJoints, false);
+	unsigned int groupStart = 0;
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		unsigned int joint = order[i];
+		int parent = parents[joint];
+		if (batches.size() - groupStart == 4 || (parent >= 0 && inGroup[parent])) {
+			// the unused slots of a group repeat its last joint, which is written twice with the same value
+			while (batches.size() - groupStart < 4) {
+				batches.push_back(batches.back());
+			}
+			for (unsigned int j = groupStart; j < batches.size(); ++j) {
+				inGroup[batches[j]] = false;
+			}
+			groupStart = (unsigned int)batches.size();
+		}
+		batches.push_back(joint);
+		inGroup[joint] = true;
+	}
+	while (batches.size() - groupStart < 4) {
+		batches.push_back(batches.back());
+	}
+}
+
+void SoAPose::updateGlobalTransforms() {
+	if (batchesDirty) {
+		updateBatches();
+	}
+	float* localStreams[NUM_STREAMS];
+	float* globalStreams[NUM_STREAMS];
+	for (int s = 0; s < NUM_STREAMS; ++s) {
+		localStreams[s] = getLocalStream((Stream)s);
+		globalStreams[s] = getGlobalStream((Stream)s);
+	}
+
+	__m128 parent[NUM_STREAMS];
+	__m128 child[NUM_STREAMS];
+	__m128 result[NUM_STREAMS];
+	float values[4];
+	for (unsigned int b = 0, numBatches = (unsigned int)batches.size(); b < numBatches; b += 4) {
+		const unsigned int* ids = &batches[b];
+		// the roots use the identity slot after the last joint as their parent
+		unsigned int parentIds[4];
+		for (int j = 0; j < 4; ++j) {
+			int p = parents[ids[j]];
+			parentIds[j] = p >= 0 ? (unsigned int)p : numJoints;
+		}
+		for (int s = 0; s < NUM_STREAMS; ++s) {
+			parent[s] = SoAHelpers::gather(globalStreams[s], parentIds);
+			child[s] = SoAHelpers::gather(localStreams[s], ids);
+		}
+		SoAHelpers::combine(parent, child, result);
+		for (int s = 0; s < NUM_STREAMS; ++s) {
+			_mm_storeu_ps(values, result[s]);
+			float* stream = globalStreams[s];
+			stream[ids[0]] = values[0];
+			stream[ids[1]] = values[1];
+			stream[ids[2]] = values[2];
+			stream[ids[3]] = values[3];
+		}
+	}
+}
+
+Transform SoAPose::getGlobalTransform(unsigned int id) {
+	float* data = SoAHelpers::aligned(globals);
+	Transform result;
+	result.position = vec3(data[POSITION_X * stride + id], data[POSITION_Y * stride + id], data[POSITION_Z * stride + id]);
+	result.rotation = quat(data[ROTATION_X * stride + id], data[ROTATION_Y * stride + id], data[ROTATION_Z * stride + id], data[ROTATION_W * stride + id]);
+	result.scale = vec3(data[SCALE_X * stride + id], data[SCALE_Y * stride + id], data[SCALE_Z * stride + id]);
+	return result;
+}
+
+void SoAPose::getGlobalMatrices(std::vector<mat4>& out) {
+	updateGlobalTransforms();
+	out.resize(numJoints);
+	const float* streams[NUM_STREAMS];
+	for (int s = 0; s < NUM_STREAMS; ++s) {
+		streams[s] = getGlobalStream((Stream)s);
+	}
+	// the arrays are padded, the last group only writes the joints of the pose
+	__m128 columns[16];
+	for (unsigned int i = 0; i < numJoints; i += 4) {
+		SoAHelpers::matrices(streams, i, columns);
+		for (unsigned int j = 0; j < 4 && i + j < numJoints; ++j) {
+			float* matrix = out[i + j].v;
+			for (int c = 0; c < 4; ++c) {
+				_mm_storeu_ps(matrix + c * 4, columns[j * 4 + c]);
+			}
+		}
+	}
+}
+
+void SoAPose::getPalette(std::vector<mat4>& out, std::vector<mat4>& invBindPose) {
+	updateGlobalTransforms();
+	out.resize(numJoints);
+	const float* streams[NUM_STREAMS];
+	for (int s = 0; s < NUM_STREAMS; ++s) {
+		streams[s] = getGlobalStream((Stream)s);
+	}
+	__m128 columns[16];
+	for (unsigned int i = 0; i < numJoints; i += 4) {
+		SoAHelpers::matrices(streams, i, columns);
+		for (unsigned int j = 0; j < 4 && i + j < numJoints; ++j) {
+			SoAHelpers::multiply(&columns[j * 4], invBindPose[i + j], out[i + j].v);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+#include "../math/transform.h"
+#include "../math/mat4.h"
+#include "pose.h"
+
+// Pose with the positions, rotations and scales of the joints in separate arrays (structure of arrays), so that the
+// global transforms, the matrices and the skin palette are evaluated 4 joints at a time with SSE.
+// The arrays are aligned to 16 bytes and padded to a multiple of 4 joints. fromPose and toPose convert from and to a
+// Pose, so the code that samples and blends Poses can keep doing it.
+class SoAPose {
+public:
+	// arrays of the components of the transforms
+	enum Stream {
+		POSITION_X = 0, POSITION_Y, POSITION_Z,
+		ROTATION_X, ROTATION_Y, ROTATION_Z, ROTATION_W,
+		SCALE_X, SCALE_Y, SCALE_Z,
+		NUM_STREAMS
+	};
+
+protected:
+	std::vector<float> locals; // NUM_STREAMS arrays of stride values with the local transforms
+	std::vector<float> globals; // same layout, global transforms. The slot after the last joint is the identity (parent of the roots)
+	std::vector<int> parents;
+	std::vector<unsigned int> batches; // joints in groups of 4, the parents of a group are in the groups before it
+	unsigned int numJoints;
+	unsigned int stride; // values of each array
+	bool batchesDirty; // the batches are rebuilt after changing the parents
+
+protected:
+	// groups the joints by depth in the hierarchy, so that the joints of a group don't depend on each other
+	void updateBatches();
+	float* getGlobalStream(Stream stream);
+
+public:
+	SoAPose();
+	// the arrays are copied without their alignment padding
+	SoAPose(const SoAPose& p);
+	SoAPose& operator=(const SoAPose& p);
+	// Initialize the pose with the hierarchy and the local transforms of a pose
+	SoAPose(Pose& pose);
+
+	void resize(unsigned int size);
+	unsigned int size();
+
+	void setParent(unsigned int id, int parentId);
+	int getParent(unsigned int id);
+
+	void setLocalTransform(unsigned int id, const Transform& transform);
+	Transform getLocalTransform(unsigned int id);
+	// Direct access to an array of the local transforms (aligned to 16 bytes)
+	float* getLocalStream(Stream stream);
+
+	// copies the hierarchy (only if it changed) and the local transforms of the pose
+	void fromPose(Pose& pose);
+	// writes the hierarchy and the local transforms into the pose
+	void toPose(Pose& outPose);
+
+	// global transforms of all the joints, 4 joints at a time
+	void updateGlobalTransforms();
+	// global transform of the joint computed by the last updateGlobalTransforms, getGlobalMatrices or getPalette
+	Transform getGlobalTransform(unsigned int id);
+	// updates the global transforms and writes their matrices into the vector (resized if needed)
+	void getGlobalMatrices(std::vector<mat4>& out);
+	// updates the global transforms and writes the skin matrices (global matrix * inverse bind pose) of the joints
+	void getPalette(std::vector<mat4>& out, std::vector<mat4>& invBindPose);
+};
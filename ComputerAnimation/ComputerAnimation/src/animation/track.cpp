@@ -3,6 +3,12 @@
 template Track<float, 1>;
 template Track<vec3, 3>;
 template Track<quat, 4>;
+template FastTrack<float, 1>;
+template FastTrack<vec3, 3>;
+template FastTrack<quat, 4>;
+template FastTrack<float, 1> optimizeTrack(Track<float, 1>& input);
+template FastTrack<vec3, 3> optimizeTrack(Track<vec3, 3>& input);
+template FastTrack<quat, 4> optimizeTrack(Track<quat, 4>& input);
 
 // This class is templated, so some functions are declared but not necessary implemented depending of the interpolation type
 
@@ -35,6 +41,21 @@ namespace TrackHelpers {
 		return normalized(q);
 	}
 
+	// error between two values of a track: distance for scalars and vectors, angle in radians for rotations
+	inline float difference(float a, float b) {
+		return fabsf(a - b);
+	}
+	inline float difference(const vec3& a, const vec3& b) {
+		return len(a - b);
+	}
+	inline float difference(const quat& a, const quat& b) {
+		float d = fabsf(dot(a, b)); // q and -q are the same rotation
+		if (d > 1.0f) {
+			d = 1.0f;
+		}
+		return 2.0f * acosf(d);
+	}
+
 	// Make sure two quaternions are in the correct neighborhood
 	inline void neighborhood(const float& a, float& b) { }
 	inline void neighborhood(const vec3& a, vec3& b) { }
@@ -43,50 +64,399 @@ namespace TrackHelpers {
 			b = -b;
 		}
 	}
+
+	// Searching the frames only needs the times, so the tracks and the timelines of the clips share these helpers
+
+	// Adjusts the time to be in the range of the start/end frames of the track.
+	inline float adjustTimeToFit(const std::vector<float>& times, float time, bool looping) {
+		unsigned int size = (unsigned int)times.size();
+		if (size <= 1) {
+			return 0.0f;
+		}
+		float startTime = times[0];
+		float endTime = times[size - 1];
+		float duration = endTime - startTime;
+		if (duration <= 0.0f) {
+			return 0.0f;
+		}
+		if (looping) {
+			time = fmodf(time - startTime, endTime - startTime);
+			if (time < 0.0f) {
+				time += endTime - startTime;
+			}
+			time = time + startTime;
+		}
+		else {
+			if (time <= times[0]) {
+				time = startTime;
+			}
+			if (time >= times[size - 1]) {
+				time = endTime;
+			}
+		}
+		return time;
+	}
+
+	// binary search of the last frame whose time is not greater than the given time
+	inline int searchFrame(const std::vector<float>& times, float time) {
+		int low = 0;
+		int high = (int)times.size() - 1;
+		if (high < 0 || time < times[0]) {
+			return -1;
+		}
+		// times[low] <= time always holds, the search ends when low is the last frame that satisfies it
+		while (low < high) {
+			int middle = (low + high + 1) / 2;
+			if (time >= times[middle]) {
+				low = middle;
+			}
+			else {
+				high = middle - 1;
+			}
+		}
+		return low;
+	}
+
+	// return the frame immediately before that time (on the left)
+	inline int frameIndex(const std::vector<float>& times, float time, bool looping, TrackCursor* cursor) {
+		unsigned int size = (unsigned int)times.size();
+		if (size <= 1) {
+			return -1;
+		}
+		// If the track is sampled as looping, the input time needs to be adjusted so that it falls between the start and end frames.
+		if (looping) {
+			float startTime = times[0];
+			float endTime = times[size - 1];
+			float duration = endTime - startTime;
+			time = fmodf(time - startTime, endTime - startTime);
+			// looping, time needs to be adjusted so that it is within a valid range.
+			if (time < 0.0f) {
+				time += endTime - startTime;
+			}
+			time = time + startTime;
+		}
+		else {
+			// clamp the time in the track frames range
+			if (time <= times[0]) {
+				return 0;
+			}
+			if (time >= times[size - 2]) {
+				// The Sample function always needs a current and next frame (for interpolation), so the index of the second-to-last frame is used.
+				return (int)size - 2;
+			}
+		}
+		if (cursor == 0) {
+			return searchFrame(times, time);
+		}
+		// Sequential playback: the time is usually in the frame of the last sample or a few frames after it (the keys can
+		// be denser than the samples, mocap at 120 fps played at 60 fps skips a frame every sample)
+		int last = cursor->frame;
+		if (last >= 0 && last < (int)size - 1 && time >= times[last]) {
+			for (int frame = last; frame < (int)size && frame <= last + 4; ++frame) {
+				if (frame + 1 >= (int)size || time < times[frame + 1]) {
+					cursor->frame = frame;
+					return frame;
+				}
+			}
+		}
+		// Cold or random seek
+		cursor->frame = searchFrame(times, time);
+		return cursor->frame;
+	}
+
+	// interpolation factor t of the time between the frame and the next one, returns -1 if the frame isn't a valid segment
+	inline int segment(const std::vector<float>& times, int thisFrame, float time, bool looping, float& t) {
+		if (thisFrame < 0 || thisFrame >= (int)times.size() - 1) {
+			return -1;
+		}
+		// make sure the time is valid
+		float trackTime = adjustTimeToFit(times, time, looping);
+		float thisTime = times[thisFrame];
+		float frameDelta = times[thisFrame + 1] - thisTime;
+		if (frameDelta <= 0.0f) {
+			return -1;
+		}
+		t = (trackTime - thisTime) / frameDelta;
+		return thisFrame;
+	}
+
+	// Lookup table of a FastTrack or a Timeline: the frame on the left of every sample of the duration, at FAST_TRACK_SAMPLE_RATE
+	inline void buildLookupTable(const std::vector<float>& times, std::vector<unsigned int>& sampledFrames, float& timeToSample) {
+		int numFrames = (int)times.size();
+		sampledFrames.clear();
+		timeToSample = 0.0f;
+		if (numFrames <= 1) {
+			return;
+		}
+		float startTime = times[0];
+		float duration = times[numFrames - 1] - startTime;
+		unsigned int numSamples = FAST_TRACK_SAMPLE_RATE + (unsigned int)(duration * FAST_TRACK_SAMPLE_RATE);
+		sampledFrames.resize(numSamples);
+		if (duration > 0.0f) {
+			timeToSample = (float)(numSamples - 1) / duration;
+		}
+		// the samples are sorted in time, so the frame of each sample is found walking forward from the previous one
+		int frame = 0;
+		for (unsigned int i = 0; i < numSamples; ++i) {
+			float t = (float)i / (float)(numSamples - 1);
+			float time = startTime + t * duration;
+			while (frame < numFrames - 2 && time >= times[frame + 1]) {
+				++frame;
+			}
+			sampledFrames[i] = frame;
+		}
+	}
+
+	// frame on the left of the time from the lookup table, the binary search if the table doesn't match the times
+	inline int lookupFrame(const std::vector<float>& times, const std::vector<unsigned int>& sampledFrames, float timeToSample,
+		float time, bool looping, TrackCursor* cursor) {
+		unsigned int size = (unsigned int)times.size();
+		if (size <= 1) {
+			return -1;
+		}
+		float startTime = times[0];
+		float endTime = times[size - 1];
+		float duration = endTime - startTime;
+		if (duration <= 0.0f) {
+			return 0;
+		}
+		if (looping) {
+			time = fmodf(time - startTime, duration);
+			if (time < 0.0f) {
+				time += duration;
+			}
+			time = time + startTime;
+		}
+		else {
+			if (time <= startTime) {
+				return 0;
+			}
+			if (time >= times[size - 2]) {
+				return (int)size - 2;
+			}
+		}
+		// a table built for other keys (times edited without updateIndexLookupTable) falls back to the binary search
+		unsigned int index = (unsigned int)((time - startTime) * timeToSample);
+		if (index >= (unsigned int)sampledFrames.size() || sampledFrames[index] > size - 2) {
+			return frameIndex(times, time, looping, cursor);
+		}
+		// the sample is at or before the time, so the frame may be behind when keys are denser than the sample rate
+		int frame = (int)sampledFrames[index];
+		while (frame < (int)size - 2 && time >= times[frame + 1]) {
+			++frame;
+		}
+		while (frame > 0 && time < times[frame]) {
+			--frame;
+		}
+		return frame;
+	}
 }; // End Track Helpers namespace
 
 template<typename T, int N>
 Track<T, N>::Track() {
 	interpolation = Interpolation::Linear;
+	times = std::make_shared<std::vector<float> >();
 }
 
 template<typename T, int N>
 float Track<T, N>::getStartTime() {
-	return frames[0].time;
+	return (*times)[0];
 }
 
 template<typename T, int N>
 float Track<T, N>::getEndTime() {
-	return frames[frames.size() - 1].time;
+	return times->back();
 }
 
 // call sampleConstant, sampleLinear, or sampleCubic, depending on the track type.
 template<typename T, int N>
-T Track<T, N>::sample(float time, bool looping) {
-	if (interpolation == Interpolation::Constant) {
-		return sampleConstant(time, looping);
+T Track<T, N>::sample(float time, bool looping, TrackCursor* cursor) {
+	if (interpolation == Interpolation::Constant || times->size() == 1) {
+		return sampleConstant(time, looping, cursor);
 	}
 	else if (interpolation == Interpolation::Linear) {
-		return sampleLinear(time, looping);
+		return sampleLinear(time, looping, cursor);
 	}
 
-	return sampleCubic(time, looping);
+	return sampleCubic(time, looping, cursor);
+}
+
+template<typename T, int N>
+typename Track<T, N>::FrameReference Track<T, N>::operator[](unsigned int index) {
+	return FrameReference(this, index);
+}
+
+template<typename T, int N>
+Frame<N> Track<T, N>::getFrame(unsigned int index) {
+	Frame<N> frame;
+	frame.time = (*times)[index];
+	for (int i = 0; i < N; ++i) {
+		frame.value[i] = values[index * N + i];
+	}
+	if (hasTangents()) {
+		for (int i = 0; i < N; ++i) {
+			frame.in[i] = inTangents[index * N + i];
+			frame.out[i] = outTangents[index * N + i];
+		}
+	}
+	return frame;
+}
+
+template<typename T, int N>
+void Track<T, N>::setFrame(unsigned int index, const Frame<N>& frame) {
+	coefficients.clear();
+	editTimes()[index] = frame.time;
+	bool frameHasTangents = false;
+	for (int i = 0; i < N; ++i) {
+		values[index * N + i] = frame.value[i];
+		if (frame.in[i] != 0.0f || frame.out[i] != 0.0f) {
+			frameHasTangents = true;
+		}
+	}
+	// the tangents are only stored when they are used
+	if (frameHasTangents && !hasTangents()) {
+		allocateTangents();
+	}
+	if (hasTangents()) {
+		for (int i = 0; i < N; ++i) {
+			inTangents[index * N + i] = frame.in[i];
+			outTangents[index * N + i] = frame.out[i];
+		}
+	}
+}
+
+template<typename T, int N>
+float Track<T, N>::getTime(unsigned int index) {
+	return (*times)[index];
+}
+
+template<typename T, int N>
+void Track<T, N>::setTime(unsigned int index, float time) {
+	coefficients.clear();
+	editTimes()[index] = time;
+}
+
+template<typename T, int N>
+float* Track<T, N>::getValue(unsigned int index) {
+	coefficients.clear();
+	return &values[index * N];
+}
+
+template<typename T, int N>
+float* Track<T, N>::getInTangent(unsigned int index) {
+	coefficients.clear();
+	if (!hasTangents()) {
+		allocateTangents();
+	}
+	return &inTangents[index * N];
+}
+
+template<typename T, int N>
+float* Track<T, N>::getOutTangent(unsigned int index) {
+	coefficients.clear();
+	if (!hasTangents()) {
+		allocateTangents();
+	}
+	return &outTangents[index * N];
+}
+
+template<typename T, int N>
+bool Track<T, N>::hasTangents() {
+	return !inTangents.empty();
+}
+
+template<typename T, int N>
+bool Track<T, N>::isBaked() {
+	return !coefficients.empty();
+}
+
+template<typename T, int N>
+void Track<T, N>::bakeCubic() {
+	coefficients.clear();
+	unsigned int size = (unsigned int)times->size();
+	if (interpolation != Interpolation::Cubic || size <= 1 || !hasTangents()) {
+		return;
+	}
+	coefficients.resize((size - 1) * 4 * N);
+	size_t fltSize = sizeof(float);
+	for (unsigned int i = 0; i < size - 1; ++i) {
+		float frameDelta = (*times)[i + 1] - (*times)[i];
+		// same inputs as sampleCubic: normalized values, slopes scaled by the segment duration, shortest path for rotations
+		T p1 = cast(&values[i * N]);
+		T p2 = cast(&values[(i + 1) * N]);
+		TrackHelpers::neighborhood(p1, p2);
+		T s1;
+		memcpy(&s1, &outTangents[i * N], N * fltSize);
+		s1 = s1 * frameDelta;
+		T s2;
+		memcpy(&s2, &inTangents[(i + 1) * N], N * fltSize);
+		s2 = s2 * frameDelta;
+		// expand the Hermite basis functions into powers of t
+		T a = p1 * 2.0f + s1 - p2 * 2.0f + s2;
+		T b = p1 * -3.0f - s1 * 2.0f + p2 * 3.0f - s2;
+		T c = s1;
+		T d = p1;
+		float* segment = &coefficients[i * 4 * N];
+		memcpy(&segment[0], &a, N * fltSize);
+		memcpy(&segment[N], &b, N * fltSize);
+		memcpy(&segment[2 * N], &c, N * fltSize);
+		memcpy(&segment[3 * N], &d, N * fltSize);
+	}
+}
+
+// Horner evaluation of the baked polynomial of a segment
+template<typename T, int N>
+T Track<T, N>::sampleBaked(int frame, float t) {
+	float* segment = &coefficients[frame * 4 * N];
+	float result[N];
+	for (int i = 0; i < N; ++i) {
+		result[i] = ((segment[i] * t + segment[N + i]) * t + segment[2 * N + i]) * t + segment[3 * N + i];
+	}
+	return cast(&result[0]); // normalizes quaternions, like adjustCurveResult
+}
+
+template<typename T, int N>
+float Track<T, N>::getBakeError(unsigned int samplesPerSegment) {
+	if (!isBaked()) {
+		return 0.0f;
+	}
+	float maxError = 0.0f;
+	for (int frame = 0, last = (int)times->size() - 1; frame < last; ++frame) {
+		for (unsigned int i = 0; i <= samplesPerSegment + 1; ++i) {
+			float t = (float)i / (float)(samplesPerSegment + 1);
+			T baked = sampleBaked(frame, t);
+			T reference = hermiteSegment(frame, t);
+			float* a = (float*)&baked; // memcpy layout, like the tangents
+			float* b = (float*)&reference;
+			for (int j = 0; j < N; ++j) {
+				maxError = fmaxf(maxError, fabsf(a[j] - b[j]));
+			}
+		}
+	}
+	return maxError;
 }
 
 template<typename T, int N>
-Frame<N>& Track<T, N>::operator[](unsigned int index) {
-	return frames[index];
+void Track<T, N>::allocateTangents() {
+	inTangents.assign(times->size() * N, 0.0f);
+	outTangents.assign(times->size() * N, 0.0f);
 }
 
 // size of the frames vector
 template<typename T, int N>
 void Track<T, N>::resize(unsigned int size) {
-	frames.resize(size);
+	coefficients.clear();
+	editTimes().resize(size);
+	values.resize(size * N);
+	if (hasTangents() || interpolation == Interpolation::Cubic) {
+		inTangents.resize(size * N);
+		outTangents.resize(size * N);
+	}
 }
 
 template<typename T, int N>
 unsigned int Track<T, N>::size() {
-	return frames.size();
+	return (unsigned int)times->size();
 }
 
 template<typename T, int N>
@@ -97,6 +467,10 @@ Interpolation Track<T, N>::getInterpolation() {
 template<typename T, int N>
 void Track<T, N>::setInterpolation(Interpolation interpolationType) {
 	interpolation = interpolationType;
+	coefficients.clear();
+	if (interpolation == Interpolation::Cubic && !hasTangents()) {
+		allocateTangents();
+	}
 }
 
 template<typename T, int N>
@@ -104,7 +478,7 @@ T Track<T, N>::hermite(float t, const T& p1, const T& s1, const T& _p2, const T&
 	T p2 = _p2;
 	TrackHelpers::neighborhood(p1, p2); // choose the short path for rotations
 	// [CA] To do: complete this function using the basis functions
-	float h_00 = (1.0f - 2.0f * t) * pow(1.0f - t, 2);
+	float h_00 = (1.0f + 2.0f * t) * pow(1.0f - t, 2);
 	float h_01 = pow(t, 2) * (3.0f - 2.0f * t);
 	float h_10 = t * pow((1.0f - t), 2);
 	float h_11 = pow(t, 2) * (t - 1.0f);
@@ -127,72 +501,162 @@ T Track<T, N>::bezier(float t, const T& p1, const T& c1, const T& _p2, const T&
 
 // return the frame immediately before that time (on the left)
 template<typename T, int N>
-int Track<T, N>::frameIndex(float time, bool looping) {
-	unsigned int size = (unsigned int)frames.size();
-	if (size <= 1) {
-		return -1;
+int Track<T, N>::frameIndex(float time, bool looping, TrackCursor* cursor) {
+	return TrackHelpers::frameIndex(*times, time, looping, cursor);
+}
+
+template<typename T, int N>
+int Track<T, N>::searchFrame(float time) {
+	return TrackHelpers::searchFrame(*times, time);
+}
+
+template<typename T, int N>
+int Track<T, N>::findSegment(float time, bool looping, float& t, TrackCursor* cursor) {
+	return TrackHelpers::segment(*times, frameIndex(time, looping, cursor), time, looping, t);
+}
+
+template<typename T, int N>
+const float* Track<T, N>::getValues() {
+	return &values[0];
+}
+
+template<typename T, int N>
+const float* Track<T, N>::getTimes() {
+	return &(*times)[0];
+}
+
+template<typename T, int N>
+const std::shared_ptr<std::vector<float> >& Track<T, N>::getSharedTimes() {
+	return times;
+}
+
+template<typename T, int N>
+void Track<T, N>::shareTimes(const std::shared_ptr<std::vector<float> >& sharedTimes) {
+	times = sharedTimes;
+}
+
+// copy on write: the tracks that share the times keep the old ones
+template<typename T, int N>
+std::vector<float>& Track<T, N>::editTimes() {
+	if (times.use_count() > 1) {
+		times = std::make_shared<std::vector<float> >(*times);
 	}
-	// If the track is sampled as looping, the input time needs to be adjusted so that it falls between the start and end frames.
-	if (looping) {
-		float startTime = frames[0].time;
-		float endTime = frames[size - 1].time;
-		float duration = endTime - startTime;
-		time = fmodf(time - startTime, endTime - startTime);
-		// looping, time needs to be adjusted so that it is within a valid range.
-		if (time < 0.0f) {
-			time += endTime - startTime;
-		}
-		time = time + startTime;
+	return *times;
+}
+
+template<typename T, int N>
+bool Track<T, N>::isConstant(float tolerance) {
+	unsigned int size = (unsigned int)times->size();
+	if (size == 0) {
+		return false;
 	}
-	else {
-		// clamp the time in the track frames range
-		if (time <= frames[0].time) {
-			return 0;
-		}
-		if (time >= frames[size - 2].time) {
-			// The Sample function always needs a current and next frame (for interpolation), so the index of the second-to-last frame is used.
-			return (int)size - 2;
+	T first = cast(&values[0]);
+	float* firstValue = (float*)&first;
+	for (unsigned int i = 1; i < size; ++i) {
+		T value = cast(&values[i * N]);
+		TrackHelpers::neighborhood(first, value); // q and -q are the same rotation
+		float* frameValue = (float*)&value;
+		for (int j = 0; j < N; ++j) {
+			if (fabsf(frameValue[j] - firstValue[j]) > tolerance) {
+				return false;
+			}
 		}
 	}
-	for (int i = (int)size - 1; i >= 0; --i) {
-		if (time >= frames[i].time) {
-			return i;
+	for (unsigned int i = 0, tangentsSize = (unsigned int)inTangents.size(); i < tangentsSize; ++i) {
+		if (fabsf(inTangents[i]) > tolerance || fabsf(outTangents[i]) > tolerance) {
+			return false;
 		}
 	}
-	// Invalid code, we should not reach here!
-	return -1;
-} // End of frameIndex
+	return true;
+}
 
-// Adjusts the time to be in the range of the start/end frames of the track.
 template<typename T, int N>
-float Track<T, N>::adjustTimeToFitTrack(float time, bool looping) {
-	unsigned int size = (unsigned int)frames.size();
-	if (size <= 1) {
-		return 0.0f;
+void Track<T, N>::collapse() {
+	if (times->empty()) {
+		return;
+	}
+	// copied into a new track so that the memory of the other frames is released
+	Track<T, N> result;
+	result.interpolation = Interpolation::Constant;
+	result.resize(1);
+	(*result.times)[0] = (*times)[0];
+	for (int i = 0; i < N; ++i) {
+		result.values[i] = values[i];
 	}
-	float startTime = frames[0].time;
-	float endTime = frames[size - 1].time;
-	float duration = endTime - startTime;
-	if (duration <= 0.0f) {
+	*this = result;
+}
+
+template<typename T, int N>
+unsigned int Track<T, N>::getByteSize() {
+	size_t floats = times->size() + values.size() + inTangents.size() + outTangents.size() + coefficients.size();
+	return (unsigned int)(floats * sizeof(float));
+}
+
+template<typename T, int N>
+float Track<T, N>::reduceKeys(float tolerance) {
+	unsigned int size = (unsigned int)times->size();
+	if (interpolation != Interpolation::Linear || size < 3) {
 		return 0.0f;
 	}
-	if (looping) {
-		time = fmodf(time - startTime, endTime - startTime);
-		if (time < 0.0f) {
-			time += endTime - startTime;
+	std::vector<unsigned int> kept;
+	kept.push_back(0);
+	float maxError = 0.0f;
+	// greedy: the segment from the last kept frame (anchor) grows while its interpolation reconstructs the frames inside it
+	unsigned int anchor = 0;
+	float anchorError = 0.0f; // error of the frames removed after the anchor
+	for (unsigned int end = 2; end < size; ++end) {
+		T start = cast(&values[anchor * N]);
+		T last = cast(&values[end * N]);
+		float segmentError = 0.0f;
+		for (unsigned int i = anchor + 1; i < end && segmentError <= tolerance; ++i) {
+			float t = ((*times)[i] - (*times)[anchor]) / ((*times)[end] - (*times)[anchor]);
+			T reconstructed = TrackHelpers::interpolate(start, last, t);
+			float error = TrackHelpers::difference(reconstructed, cast(&values[i * N]));
+			if (error > segmentError) {
+				segmentError = error;
+			}
+		}
+		if (segmentError > tolerance) {
+			// the previous frame is needed, the frames before it are reconstructed within the tolerance
+			kept.push_back(end - 1);
+			anchor = end - 1;
+			if (anchorError > maxError) {
+				maxError = anchorError;
+			}
+			anchorError = 0.0f;
 		}
-		time = time + startTime;
+		else {
+			anchorError = segmentError;
+		}
+	}
+	if (anchorError > maxError) {
+		maxError = anchorError;
+	}
+	kept.push_back(size - 1);
+	if (kept.size() == size) {
+		return maxError;
 	}
 
-	else {
-		if (time <= frames[0].time) {
-			time = startTime;
-		}
-		if (time >= frames[size - 1].time) {
-			time = endTime;
+	std::vector<float> keptTimes(kept.size());
+	std::vector<float> keptValues(kept.size() * N);
+	for (unsigned int i = 0, keptSize = (unsigned int)kept.size(); i < keptSize; ++i) {
+		keptTimes[i] = (*times)[kept[i]];
+		for (int j = 0; j < N; ++j) {
+			keptValues[i * N + j] = values[kept[i] * N + j];
 		}
 	}
-	return time;
+	editTimes().swap(keptTimes);
+	values.swap(keptValues);
+	inTangents.clear(); // linear tracks don't use the tangents
+	outTangents.clear();
+	coefficients.clear();
+	return maxError;
+}
+
+// Adjusts the time to be in the range of the start/end frames of the track.
+template<typename T, int N>
+float Track<T, N>::adjustTimeToFitTrack(float time, bool looping) {
+	return TrackHelpers::adjustTimeToFit(*times, time, looping);
 }
 
 // They cast a float array stored in a Frame class into the data type that the Frame class represents
@@ -211,63 +675,140 @@ template<> quat Track<quat, 4>::cast(float* value) {
 
 // often used for things such as visibility flags, where it makes sense for the value of a variable to change from one frame to the next without any real interpolation
 template<typename T, int N>
-T Track<T, N>::sampleConstant(float t, bool loop) {
-	int frame = frameIndex(t, loop);
-	if (frame < 0 || frame >= (int)frames.size()) {
+T Track<T, N>::sampleConstant(float t, bool loop, TrackCursor* cursor) {
+	int frame = times->size() == 1 ? 0 : frameIndex(t, loop, cursor); // a single frame is a constant channel
+	if (frame < 0 || frame >= (int)times->size()) {
 		return T();
 	}
-	return cast(&frames[frame].value[0]);
+	return cast(&values[frame * N]);
 }
 
 // applications provide an option to approximate animation curves by sampling them at set intervals
 template<typename T, int N>
-T Track<T, N>::sampleLinear(float time, bool looping) {
-	int thisFrame = frameIndex(time, looping);
-	if (thisFrame < 0 || thisFrame >= frames.size() - 1) {
+T Track<T, N>::sampleLinear(float time, bool looping, TrackCursor* cursor) {
+	float t;
+	int thisFrame = findSegment(time, looping, t, cursor);
+	if (thisFrame < 0) {
 		return T();
 	}
+	return linearSegment(thisFrame, t);
+}
+
+template<typename T, int N>
+T Track<T, N>::linearSegment(int thisFrame, float t) {
 	int nextFrame = thisFrame + 1;
-	// make sure the time is valid
-	float trackTime = adjustTimeToFitTrack(time, looping);
-	float thisTime = frames[thisFrame].time;
-	float frameDelta = frames[nextFrame].time - thisTime;
-	if (frameDelta <= 0.0f) {
-		return T();
-	}
-	float t = (trackTime - thisTime) / frameDelta;
-	T start = cast(&frames[thisFrame].value[0]);
-	T end = cast(&frames[nextFrame].value[0]);
+	T start = cast(&values[thisFrame * N]);
+	T end = cast(&values[nextFrame * N]);
 	return TrackHelpers::interpolate(start, end, t);
 }
 
 template<typename T, int N>
-T Track<T, N>::sampleCubic(float time, bool looping) {
-	int thisFrame = frameIndex(time, looping);
-	if (thisFrame < 0 || thisFrame >= frames.size() - 1) {
+T Track<T, N>::sampleCubic(float time, bool looping, TrackCursor* cursor) {
+	float t;
+	int thisFrame = findSegment(time, looping, t, cursor);
+	if (thisFrame < 0) {
 		return T();
 	}
-	int nextFrame = thisFrame + 1;
+	return cubicSegment(thisFrame, t);
+}
 
-	float trackTime = adjustTimeToFitTrack(time, looping);
-	float thisTime = frames[thisFrame].time;
-	float frameDelta = frames[nextFrame].time - thisTime;
-	if (frameDelta <= 0.0f) {
-		return T();
+template<typename T, int N>
+T Track<T, N>::cubicSegment(int thisFrame, float t) {
+	if (isBaked()) {
+		return sampleBaked(thisFrame, t);
 	}
+	return hermiteSegment(thisFrame, t);
+}
+
+template<typename T, int N>
+T Track<T, N>::hermiteSegment(int thisFrame, float t) {
+	int nextFrame = thisFrame + 1;
+	float frameDelta = (*times)[nextFrame] - (*times)[thisFrame];
 
 	// cast function normalizes quaternions, which is bad because slopes are not meant to be quaternions.
 	// Using memcpy instead of cast copies the values directly, avoiding normalization.
-	float t = (trackTime - thisTime) / frameDelta;
 	size_t fltSize = sizeof(float);
-	T point1 = cast(&frames[thisFrame].value[0]);
-	T slope1;// = frames[thisFrame].out * frameDelta;
-	memcpy(&slope1, frames[thisFrame].out, N * fltSize); // memcpy instead of cast to avoid normalization
-	slope1 = slope1 * frameDelta;
-	T point2 = cast(&frames[nextFrame].value[0]);
-	T slope2;// = frames[nextFrame].in[0] * frameDelta;
-	memcpy(&slope2, frames[nextFrame].in, N * fltSize);
-	slope2 = slope2 * frameDelta;
+	T point1 = cast(&values[thisFrame * N]);
+	T point2 = cast(&values[nextFrame * N]);
+	T slope1 = T() * 0.0f; // tracks without tangents have flat slopes
+	T slope2 = T() * 0.0f;
+	if (hasTangents()) {
+		memcpy(&slope1, &outTangents[thisFrame * N], N * fltSize); // memcpy instead of cast to avoid normalization
+		slope1 = slope1 * frameDelta;
+		memcpy(&slope2, &inTangents[nextFrame * N], N * fltSize);
+		slope2 = slope2 * frameDelta;
+	}
 
 	return hermite(t, point1, slope1, point2, slope2); // [CA] To do: call the hermite or bezier methods
 	//return bezier(t, point1, slope1, point2, slope2);
+}
+
+// Timeline
+
+Timeline::Timeline() {
+	times = std::make_shared<std::vector<float> >();
+	timeToSample = 0.0f;
+}
+
+Timeline::Timeline(const std::shared_ptr<std::vector<float> >& inTimes) : times(inTimes) {
+	timeToSample = 0.0f;
+}
+
+void Timeline::updateIndexLookupTable() {
+	TrackHelpers::buildLookupTable(*times, sampledFrames, timeToSample);
+}
+
+unsigned int Timeline::size() {
+	return (unsigned int)times->size();
+}
+
+const std::shared_ptr<std::vector<float> >& Timeline::getTimes() {
+	return times;
+}
+
+bool Timeline::matches(const float* otherTimes, unsigned int size) {
+	if (size != times->size()) {
+		return false;
+	}
+	if (size == 0 || otherTimes == &(*times)[0]) {
+		return true; // the track already shares the times of the timeline
+	}
+	for (unsigned int i = 0; i < size; ++i) {
+		if ((*times)[i] != otherTimes[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int Timeline::findSegment(float time, bool looping, float& t, TrackCursor* cursor) {
+	// without a lookup table, lookupFrame is the search of Track::frameIndex
+	return TrackHelpers::segment(*times, TrackHelpers::lookupFrame(*times, sampledFrames, timeToSample, time, looping, cursor), time, looping, t);
+}
+
+// Fast track
+
+template<typename T, int N>
+FastTrack<T, N> optimizeTrack(Track<T, N>& input) {
+	FastTrack<T, N> result;
+	// copy the arrays of the track
+	Track<T, N>& resultTrack = result;
+	resultTrack = input;
+	result.updateIndexLookupTable();
+	return result;
+}
+
+template<typename T, int N>
+FastTrack<T, N>::FastTrack() {
+	timeToSample = 0.0f;
+}
+
+template<typename T, int N>
+void FastTrack<T, N>::updateIndexLookupTable() {
+	TrackHelpers::buildLookupTable(*this->times, sampledFrames, timeToSample);
+}
+
+template<typename T, int N>
+int FastTrack<T, N>::frameIndex(float time, bool looping, TrackCursor* cursor) {
+	return TrackHelpers::lookupFrame(*this->times, sampledFrames, timeToSample, time, looping, cursor);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "frame.h"
 #include <vector>
+#include <memory>
 #include "../math/vec3.h"
 #include "../math/quat.h"
 
@@ -11,32 +12,169 @@ enum class Interpolation {
 	Cubic
 };
 
-// Collection of frames
+// Playback state of a track: remembers the frame found by the last sample, so that the next sample of the same playback
+// only has to check that frame and the following one instead of searching the whole track
+struct TrackCursor {
+	int frame;
+
+	inline TrackCursor() : frame(-1) { }
+};
+
+template<typename T, int N>
+class Track;
+
+// Interpolation policies: fix the interpolation used to sample a track at compile time (see Track::sample<POLICY>)
+struct ConstantInterpolation {
+	static const Interpolation type = Interpolation::Constant;
+	template<typename T, int N>
+	static inline T sample(Track<T, N>& track, float time, bool looping, TrackCursor* cursor) {
+		return track.sampleConstant(time, looping, cursor);
+	}
+	// value of the frame, found by the caller (see Timeline::findSegment)
+	template<typename T, int N>
+	static inline T sampleSegment(Track<T, N>& track, int frame, float /*t*/) {
+		return track.cast(&track.values[frame * N]);
+	}
+};
+
+struct LinearInterpolation {
+	static const Interpolation type = Interpolation::Linear;
+	template<typename T, int N>
+	static inline T sample(Track<T, N>& track, float time, bool looping, TrackCursor* cursor) {
+		return track.sampleLinear(time, looping, cursor);
+	}
+	template<typename T, int N>
+	static inline T sampleSegment(Track<T, N>& track, int frame, float t) {
+		return track.linearSegment(frame, t);
+	}
+};
+
+struct CubicInterpolation {
+	static const Interpolation type = Interpolation::Cubic;
+	template<typename T, int N>
+	static inline T sample(Track<T, N>& track, float time, bool looping, TrackCursor* cursor) {
+		return track.sampleCubic(time, looping, cursor);
+	}
+	template<typename T, int N>
+	static inline T sampleSegment(Track<T, N>& track, int frame, float t) {
+		return track.cubicSegment(frame, t);
+	}
+};
+
+// Collection of frames, stored as separate arrays so that searching a time only touches the times array.
+// Tangents are only allocated when the track is cubic or one of its frames has tangents.
 template<typename T, int N>
 class Track {
+public:
+	// Returned by operator[]: reads and writes a frame of the track as a whole
+	class FrameReference {
+	protected:
+		Track* track;
+		unsigned int index;
+	public:
+		inline FrameReference(Track* t, unsigned int i) : track(t), index(i) { }
+		inline FrameReference& operator=(const Frame<N>& frame) {
+			track->setFrame(index, frame);
+			return *this;
+		}
+		inline FrameReference& operator=(const FrameReference& other) {
+			track->setFrame(index, other.track->getFrame(other.index));
+			return *this;
+		}
+		inline operator Frame<N>() const {
+			return track->getFrame(index);
+		}
+	};
 protected:
-	std::vector<Frame<N>> frames;
+	// one per frame, shared by the copies of the track and the tracks of a clip with the same times (see editTimes)
+	std::shared_ptr<std::vector<float> > times;
+	std::vector<float> values; // N per frame
+	std::vector<float> inTangents; // N per frame, empty if the track has no tangents
+	std::vector<float> outTangents; // N per frame, empty if the track has no tangents
+	// 4 * N per segment of a baked cubic track: the a, b, c and d of value(t) = ((a * t + b) * t + c) * t + d
+	std::vector<float> coefficients;
 	Interpolation interpolation; // interpolation type
 public:
 	Track();
+	virtual ~Track() {}
 	void resize(unsigned int size);
 	unsigned int size();
 	Interpolation getInterpolation();
+	// setting cubic interpolation allocates the tangents
 	void setInterpolation(Interpolation interp);
 	float getStartTime();
 	float getEndTime();
-	// parameters: time value, if the track is looping or not
-	T sample(float time, bool looping);
-	Frame<N>& operator[](unsigned int index);
+	// parameters: time value, if the track is looping or not, optional cursor of the playback
+	T sample(float time, bool looping, TrackCursor* cursor = 0);
+	// samples with the interpolation of the policy instead of switching on the interpolation of the track,
+	// the caller is responsible for the policy matching getInterpolation()
+	template<typename POLICY>
+	inline T sample(float time, bool looping, TrackCursor* cursor = 0) {
+		return POLICY::sample(*this, time, looping, cursor);
+	}
+	FrameReference operator[](unsigned int index);
+
+	Frame<N> getFrame(unsigned int index);
+	void setFrame(unsigned int index, const Frame<N>& frame);
+	float getTime(unsigned int index);
+	void setTime(unsigned int index, float time);
+	// N floats of the value of the frame
+	float* getValue(unsigned int index);
+	// N floats of the tangents of the frame, the tangents are allocated if the track doesn't have them
+	float* getInTangent(unsigned int index);
+	float* getOutTangent(unsigned int index);
+	bool hasTangents();
+	// finds the frame on the left of the time and the interpolation factor t towards the next frame,
+	// returns -1 if the track can't be interpolated at that time
+	int findSegment(float time, bool looping, float& t, TrackCursor* cursor = 0);
+	// N floats per frame, read only (used by the batched sampling of the clips)
+	const float* getValues();
+	// one float per frame, read only (used by the shared timelines of the clips)
+	const float* getTimes();
+	const std::shared_ptr<std::vector<float> >& getSharedTimes();
+	// uses the given times for the frames instead of its own ones, which must have the same values (see TClip::shareTimelines)
+	void shareTimes(const std::shared_ptr<std::vector<float> >& sharedTimes);
+	// true if the values of all the frames are within the tolerance of the first one and the tangents are flat
+	bool isConstant(float tolerance);
+	// keeps only the value of the first frame: the track becomes a constant channel, sampled without searching frames
+	void collapse();
+	// bytes used by the frames of the track
+	unsigned int getByteSize();
+	// Removes the frames that the linear interpolation of the remaining frames reconstructs within the tolerance
+	// (a distance for scalars and vectors, an angle in radians for quaternions). Only linear tracks are reduced.
+	// Returns the maximum error of the removed frames.
+	float reduceKeys(float tolerance);
+	// Precomputes the Hermite polynomial of every segment of a cubic track, so that sampling doesn't scale the tangents
+	// nor evaluate the basis functions. Any change to the frames discards the baked coefficients.
+	void bakeCubic();
+	bool isBaked();
+	// largest difference of a component between the baked polynomials and the Hermite basis functions, sampled at the
+	// frames and at the given number of points inside every segment (0 if the track isn't baked)
+	float getBakeError(unsigned int samplesPerSegment);
 protected:
+	friend struct ConstantInterpolation;
+	friend struct LinearInterpolation;
+	friend struct CubicInterpolation;
+
+	void allocateTangents();
+	// times of the frames for a change, copied first if they are shared
+	std::vector<float>& editTimes();
+	T sampleBaked(int frame, float t);
+
 	// helper functions, a sample for each type of interpolation
-	T sampleConstant(float time, bool looping);
-	T sampleLinear(float time, bool looping);
-	T sampleCubic(float time, bool looping);
+	T sampleConstant(float time, bool looping, TrackCursor* cursor);
+	T sampleLinear(float time, bool looping, TrackCursor* cursor);
+	T sampleCubic(float time, bool looping, TrackCursor* cursor);
+	// interpolation of the segment that starts at the frame, t in [0, 1]
+	T linearSegment(int frame, float t);
+	T cubicSegment(int frame, float t);
+	T hermiteSegment(int frame, float t);
 	// helper function to evaluate Hermite splines (tangents)
 	T hermite(float time, const T& p1, const T& s1, const T& _p2, const T& s2);
 	T bezier(float t, const T& p1, const T& c1, const T& _p2, const T& c2);
-	int frameIndex(float time, bool looping);
+	virtual int frameIndex(float time, bool looping, TrackCursor* cursor = 0);
+	// binary search of the last frame whose time is not greater than the given time
+	int searchFrame(float time);
 	// takes an input time that is outside the range of the track and adjusts it to be a valid time on the track
 	float adjustTimeToFitTrack(float t, bool loop);
 
@@ -46,4 +184,48 @@ protected:
 
 typedef Track<float, 1> ScalarTrack;
 typedef Track<vec3, 3> VectorTrack;
-typedef Track<quat, 4> QuaternionTrack;
\ No newline at end of file
+typedef Track<quat, 4> QuaternionTrack;
+
+// number of samples per second of the lookup table of a FastTrack
+#define FAST_TRACK_SAMPLE_RATE 60
+
+// Times of the frames shared by several tracks of a clip: the clip finds the segment of the time once per timeline,
+// and the tracks interpolate that segment (see TClip::shareTimelines)
+class Timeline {
+protected:
+	std::shared_ptr<std::vector<float> > times; // the same array as the times of the tracks of the timeline
+	std::vector<unsigned int> sampledFrames; // lookup table of the timelines of a FastClip, same as FastTrack
+	float timeToSample;
+public:
+	Timeline();
+	Timeline(const std::shared_ptr<std::vector<float> >& inTimes);
+	unsigned int size();
+	const std::shared_ptr<std::vector<float> >& getTimes();
+	// true if the times are the same as the given ones
+	bool matches(const float* otherTimes, unsigned int size);
+	// same as Track::findSegment, or FastTrack::findSegment once the lookup table is built
+	int findSegment(float time, bool looping, float& t, TrackCursor* cursor = 0);
+	void updateIndexLookupTable();
+};
+
+// Track with a lookup table that maps a uniformly quantized time to the frame on its left,
+// so finding the frame to sample is a multiplication and a table lookup instead of a search
+template<typename T, int N>
+class FastTrack : public Track<T, N> {
+protected:
+	std::vector<unsigned int> sampledFrames; // frame index of every sample of the track duration
+	float timeToSample; // converts a time relative to the track start into a sample index
+	virtual int frameIndex(float time, bool looping, TrackCursor* cursor = 0);
+public:
+	FastTrack();
+	// must be called after the frames of the track change
+	void updateIndexLookupTable();
+};
+
+typedef FastTrack<float, 1> FastScalarTrack;
+typedef FastTrack<vec3, 3> FastVectorTrack;
+typedef FastTrack<quat, 4> FastQuaternionTrack;
+
+// copies the frames of a track into a FastTrack and builds its lookup table
+template<typename T, int N>
+FastTrack<T, N> optimizeTrack(Track<T, N>& input);
\ No newline at end of file
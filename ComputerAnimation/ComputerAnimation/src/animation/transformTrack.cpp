@@ -1,36 +1,47 @@
 #include "transformTrack.h"
 
-TransformTrack::TransformTrack() {
+template TTransformTrack<VectorTrack, QuaternionTrack>;
+template TTransformTrack<FastVectorTrack, FastQuaternionTrack>;
+
+template <typename VTRACK, typename QTRACK>
+TTransformTrack<VTRACK, QTRACK>::TTransformTrack() {
 	id = 0;
 }
 
-unsigned int TransformTrack::getId() {
+template <typename VTRACK, typename QTRACK>
+unsigned int TTransformTrack<VTRACK, QTRACK>::getId() {
 	return id;
 }
 
-void TransformTrack::setId(unsigned int index) {
+template <typename VTRACK, typename QTRACK>
+void TTransformTrack<VTRACK, QTRACK>::setId(unsigned int index) {
 	id = index;
 }
 
-VectorTrack& TransformTrack::getPositionTrack() {
+template <typename VTRACK, typename QTRACK>
+VTRACK& TTransformTrack<VTRACK, QTRACK>::getPositionTrack() {
 	return position;
 }
 
-QuaternionTrack& TransformTrack::getRotationTrack() {
+template <typename VTRACK, typename QTRACK>
+QTRACK& TTransformTrack<VTRACK, QTRACK>::getRotationTrack() {
 	return rotation;
 }
 
-VectorTrack& TransformTrack::getScaleTrack() {
+template <typename VTRACK, typename QTRACK>
+VTRACK& TTransformTrack<VTRACK, QTRACK>::getScaleTrack() {
 	return scale;
 }
 
-bool TransformTrack::isValid() {
+template <typename VTRACK, typename QTRACK>
+bool TTransformTrack<VTRACK, QTRACK>::isValid() {
 	return position.size() > 1 ||
 		rotation.size() > 1 ||
 		scale.size() > 1;
 }
 
-float TransformTrack::getStartTime() {
+template <typename VTRACK, typename QTRACK>
+float TTransformTrack<VTRACK, QTRACK>::getStartTime() {
 	float result = 0.0f;
 	bool isSet = false;
 	if (position.size() > 1) {
@@ -54,7 +65,8 @@ float TransformTrack::getStartTime() {
 	return result;
 }
 
-float TransformTrack::getEndTime() {
+template <typename VTRACK, typename QTRACK>
+float TTransformTrack<VTRACK, QTRACK>::getEndTime() {
 	float result = 0.0f;
 	bool isSet = false;
 	if (position.size() > 1) {
@@ -78,18 +90,28 @@ float TransformTrack::getEndTime() {
 	return result;
 }
 
-// only samples one of its component tracks if that track has two or more frames
-Transform TransformTrack::sample(const Transform& ref, float time, bool loop) {
+// only samples one of its component tracks if that track has frames
+template <typename VTRACK, typename QTRACK>
+Transform TTransformTrack<VTRACK, QTRACK>::sample(const Transform& ref, float time, bool loop, TrackCursor* cursors) {
 	// If one of the transform components isn't animated by the transform track, the value of the reference transform is used 
 	Transform result = ref; // Assign default values
-	if (position.size() > 1) { // Only if valid
-		result.position = position.sample(time, loop);
+	if (position.size() > 0) { // Only if valid
+		result.position = position.sample(time, loop, cursors ? &cursors[0] : 0);
 	}
-	if (rotation.size() > 1) { // Only if valid
-		result.rotation = rotation.sample(time, loop);
+	if (rotation.size() > 0) { // Only if valid
+		result.rotation = rotation.sample(time, loop, cursors ? &cursors[1] : 0);
 	}
-	if (scale.size() > 1) { // Only if valid
-		result.scale = scale.sample(time, loop);
+	if (scale.size() > 0) { // Only if valid
+		result.scale = scale.sample(time, loop, cursors ? &cursors[2] : 0);
 	}
 	return result;
+}
+
+FastTransformTrack optimizeTransformTrack(TransformTrack& input) {
+	FastTransformTrack result;
+	result.setId(input.getId());
+	result.getPositionTrack() = optimizeTrack<vec3, 3>(input.getPositionTrack());
+	result.getRotationTrack() = optimizeTrack<quat, 4>(input.getRotationTrack());
+	result.getScaleTrack() = optimizeTrack<vec3, 3>(input.getScaleTrack());
+	return result;
 }
\ No newline at end of file
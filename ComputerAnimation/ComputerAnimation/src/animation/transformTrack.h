@@ -4,21 +4,30 @@
 #include "../math/transform.h"
 
 // binds a transform to a joint
-class TransformTrack {
+template <typename VTRACK, typename QTRACK>
+class TTransformTrack {
 protected:
 	unsigned int id; // joint Id
-	VectorTrack position;
-	QuaternionTrack rotation;
-	VectorTrack scale;
+	VTRACK position;
+	QTRACK rotation;
+	VTRACK scale;
 public:
-	TransformTrack();
+	TTransformTrack();
 	unsigned int getId();
 	void setId(unsigned int id);
-	VectorTrack& getPositionTrack();
-	QuaternionTrack& getRotationTrack();
-	VectorTrack& getScaleTrack();
+	VTRACK& getPositionTrack();
+	QTRACK& getRotationTrack();
+	VTRACK& getScaleTrack();
 	float getStartTime();
 	float getEndTime();
 	bool isValid();
-	Transform sample(const Transform& ref, float time, bool looping);
-};
\ No newline at end of file
+	// a component track with a single frame is a constant channel, an empty one keeps the value of the reference
+	// cursors: optional array of three cursors (position, rotation and scale) of the playback
+	Transform sample(const Transform& ref, float time, bool looping, TrackCursor* cursors = 0);
+};
+
+typedef TTransformTrack<VectorTrack, QuaternionTrack> TransformTrack;
+typedef TTransformTrack<FastVectorTrack, FastQuaternionTrack> FastTransformTrack;
+
+// converts the component tracks of a transform track into fast tracks
+FastTransformTrack optimizeTransformTrack(TransformTrack& input);
@@ -49,6 +49,7 @@ void Lab2::init() {
 	
 	// for TASK 4
 	initMeshesFromGLTF(gltf);
+	skinningPool = new WorkerPool();
 	
 	freeGLTFFile(gltf);
 
@@ -333,9 +334,10 @@ void Lab2::update(float inDeltaTime) {
 	else pose = skeleton.getRestPose();
     
     // For each mesh, apply the skinning using the rest pose of the skeleton
+    skeleton.getSkinPalette(pose, posePalette);
     for (int i = 0; i < meshes.size(); ++i)
     {
-        meshes[i].CPUSkin(skeleton, pose);
+        meshes[i].CPUSkin(posePalette, *skinningPool);
     }
 }
 
@@ -469,6 +471,7 @@ void Lab2::shutdown() {
 	delete bindPoseHelper;
 	delete shader;
     delete shader_skin;
+	delete skinningPool;
 }
 
 void Lab2::onKeyDown(int key, int scancode) { 
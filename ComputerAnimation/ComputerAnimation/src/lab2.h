@@ -38,6 +38,8 @@ protected:
 
 	// for task 4
 	std::vector<Mesh> meshes;
+	std::vector<mat4> posePalette; // skin matrices of the pose
+	WorkerPool* skinningPool; // threads of the CPU skinning
 	Shader* shader;
     Shader* shader_skin;
 	Texture* diffuseTexture = NULL;
@@ -8,6 +8,7 @@
 #include "../shading/uniform.h"
 #include "../math/quat.h"
 #include "animation/blending.h"
+#include "../animation/compressedClip.h"
 		
 const char* Lab3::tasks[] = { "Tracks", "Interpolation", "Clip animation", "Additive", "Crossfade" };
 const char* Lab3::interpolation[] = { "Step", "Linear", "Cubic" };
@@ -46,19 +47,27 @@ void Lab3::init() {
 	meshes = loadMeshes(gltf);
 	skeleton = loadSkeleton(gltf);
 	clips = loadAnimationClips(gltf);
+	Pose restPose = skeleton.getRestPose();
+	for (unsigned int i = 0, size = (unsigned int)clips.size(); i < size; ++i) {
+		constantChannels.push_back(removeConstantChannels(clips[i], restPose));
+		fastClips.push_back(optimizeClip(clips[i]));
+	}
 
 	freeGLTFFile(gltf);
 
 	// Load shaders to render the meshes
-	shader = new Shader("shaders/skinned.vs", "shaders/texture.fs");
+	shader = new Shader("shaders/skinned_3x4.vs", "shaders/texture.fs");
+	dqShader = new Shader("shaders/skinned_dq.vs", "shaders/texture.fs");
+	dualQuaternionSkinning = 0;
 
 	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
 		meshes[i].updateOpenGLBuffers();
 	}
 
+	skinningPool = new WorkerPool();
+
 	animInfo.animatedPose = skeleton.getRestPose();
-	animInfo.poseMatrices.resize(skeleton.getRestPose().size());
-	animInfo.poseMatrices = animInfo.animatedPose.getGlobalMatrices();
+	updatePalette();
 	// Setup initial state for task 1
 	animInfo.model.position = vec3(-2, 0, 0);
 	animInfo.model.rotation = quat(0, 0.707, 0, 0.707);
@@ -85,8 +94,20 @@ void Lab3::init() {
 	selectedFrame = 0;
 	
 	// TASK 3:
+	// find the joints of the arms in the skeleton (the joint indices depend on the order of the joints of the file)
+	leftArmJoint = 0;
+	rightForeArmJoint = 0;
+	std::vector<std::string>& jointNames = skeleton.getJointNames();
+	for (unsigned int i = 0, size = (unsigned int)jointNames.size(); i < size; ++i) {
+		if (jointNames[i] == "LeftArm") {
+			leftArmJoint = i;
+		}
+		if (jointNames[i] == "RightForeArm") {
+			rightForeArmJoint = i;
+		}
+	}
 	// Get the rotation track of the joint that you want to apply the animation. Assign this rotation track to a refrence QuaternionTrack variable
-	QuaternionTrack &qt_la = clip[13].getRotationTrack(); // idx 13 corresponds to left arm joint
+	QuaternionTrack &qt_la = clip[leftArmJoint].getRotationTrack();
 	// [CA] To do: Resize the track with the number of frames and assign the type of interpolation
 	qt_la.resize(3); //5
 	// [CA] To do: Create the quaternion frames
@@ -96,11 +117,11 @@ void Lab3::init() {
 	//qt_la[3] = makeQuaternionFrame(3.0f, quat(0.0f, 0.0f, 0.0f, 1.0f), quat(0.0f, 0.0f, 0.0f, -1.0f), quat(0.0f, 0.0f, 0.0f, 1.0f));
 	//qt_la[4] = makeQuaternionFrame(4.0f, quat(0.0f, 0.0f, 0.0f, 1.0f), quat(0.0f, 0.0f, 0.707f, 0.707f), quat(0.0f, 0.0f, 0.0f, 1.0f));
 	// [CA] To do: Assign the transformation track to the track of the clip for the specific joint
-	clip[13].getRotationTrack() = qt_la;
+	clip[leftArmJoint].getRotationTrack() = qt_la;
 	// [CA] To do: Recalculate the duration of the clip
 	clip.recalculateDuration();
 	
-	QuaternionTrack& qt_ra = clip[24].getRotationTrack(); // idx 24 corresponds to right fore-arm joint
+	QuaternionTrack& qt_ra = clip[rightForeArmJoint].getRotationTrack();
 	// [CA] To do: Resize the track with the number of frames and assign the type of interpolation
 	qt_ra.resize(3);
 	// [CA] To do: Create the quaternion frames
@@ -108,7 +129,7 @@ void Lab3::init() {
 	qt_ra[1] = makeQuaternionFrame(1.0f, quat(0.0f, 0.0f, 0.0f, 1.0f), quat(0.0f, 0.707f, -0.707f, 0.707f), quat(0.0f, 0.0f, 0.0f, 1.0f));
 	qt_ra[2] = makeQuaternionFrame(2.0f, quat(0.0f, 0.0f, 0.0f, 1.0f), quat(0.0f, 0.0f, 0.0f, 0.0f), quat(0.0f, 0.0f, 0.0f, 1.0f));
 	// [CA] To do: Assign the transformation track to the track of the clip for the specific joint
-	clip[24].getRotationTrack() = qt_ra;
+	clip[rightForeArmJoint].getRotationTrack() = qt_ra;
 	// [CA] To do: Recalculate the duration of the clip
 	clip.recalculateDuration();
 
@@ -173,22 +194,27 @@ void Lab3::render(float inAspectRatio) {
 		case TASK1: case TASK2: case TASK3: case TASK4:
 		{
 				// GPU Skinned Mesh
-				shader->Bind();
-				Uniform<mat4>::Set(shader->GetUniform("model"), model * model_aux);
-				Uniform<mat4>::Set(shader->GetUniform("view_projection"), view_projection);
-				Uniform<vec3>::Set(shader->GetUniform("light"), vec3(1, 1, 1));
-
-				Uniform<mat4>::Set(shader->GetUniform("pose"), animInfo.poseMatrices);
-				Uniform<mat4>::Set(shader->GetUniform("invBindPose"), skeleton.getInvBindPose());
+				Shader* skinShader = dualQuaternionSkinning ? dqShader : shader;
+				skinShader->Bind();
+				Uniform<mat4>::Set(skinShader->GetUniform("model"), model * model_aux);
+				Uniform<mat4>::Set(skinShader->GetUniform("view_projection"), view_projection);
+				Uniform<vec3>::Set(skinShader->GetUniform("light"), vec3(1, 1, 1));
+
+				if (dualQuaternionSkinning) {
+					Uniform<dualquat>::Set(skinShader->GetUniform("dqPalette"), animInfo.dqPalette);
+				}
+				else {
+					Uniform<mat3x4>::Set(skinShader->GetUniform("palette"), animInfo.packedPalette);
+				}
 
-				tex->Set(shader->GetUniform("tex0"), 0);
+				tex->Set(skinShader->GetUniform("tex0"), 0);
 				for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
-					meshes[i].bind(shader->GetAttribute("position"), shader->GetAttribute("normal"), shader->GetAttribute("texCoord"), shader->GetAttribute("weights"), shader->GetAttribute("joints"));
+					meshes[i].bind(skinShader->GetAttribute("position"), skinShader->GetAttribute("normal"), skinShader->GetAttribute("texCoord"), skinShader->GetAttribute("weights"), skinShader->GetAttribute("joints"));
 					meshes[i].draw();
-					meshes[i].unBind(shader->GetAttribute("position"), shader->GetAttribute("normal"), shader->GetAttribute("texCoord"), shader->GetAttribute("weights"), shader->GetAttribute("joints"));
+					meshes[i].unBind(skinShader->GetAttribute("position"), skinShader->GetAttribute("normal"), skinShader->GetAttribute("texCoord"), skinShader->GetAttribute("weights"), skinShader->GetAttribute("joints"));
 				}
 				tex->UnSet(0);
-				shader->UnBind();
+				skinShader->UnBind();
 				break;
 		}
 	}
@@ -207,30 +233,42 @@ void Lab3::render(float inAspectRatio) {
 }
 
 void Lab3::update(float inDeltaTime) {
+	// the clips have no tracks for the channels equal to the rest pose, so their joints keep the values of the pose
+	animInfo.animatedPose = skeleton.getRestPose();
 
 	switch (currentTask) {
 		case TASK1: case TASK2:
 		{
-			// [CA] To do: Sample the given clip and update poseMatrices the animInfo
-			animInfo.playback = clips[animInfo.clip].sample(animInfo.animatedPose, currentTime);
-			animInfo.poseMatrices = animInfo.animatedPose.getGlobalMatrices();
+			// [CA] To do: Sample the given clip and update the palette of the animInfo
+			animInfo.playback = fastClips[animInfo.clip].sample(animInfo.animatedPose, currentTime, &animInfo.cursor);
+			updatePalette();
 
 			// [CA] To do: Update objectTransform with the track information
 			for (unsigned int i = 0; i < meshes.size(); i++) {
-				meshes[i].CPUSkin(skeleton, animInfo.animatedPose);
+				if (dualQuaternionSkinning) {
+					meshes[i].CPUSkin(animInfo.dqPalette, *skinningPool);
+				}
+				else {
+					meshes[i].CPUSkin(animInfo.posePalette, *skinningPool);
+				}
 				meshes[i].updateOpenGLBuffers();
 			}
 			break;
 		}
 		 case TASK3:
 		 {
-			 // [CA] To do: Sample YOUR CLIP and update poseMatrices the animInfo
+			 // [CA] To do: Sample YOUR CLIP and update the palette of the animInfo
 			 animInfo.playback = clip.sample(animInfo.animatedPose, currentTime);
-			 animInfo.poseMatrices = animInfo.animatedPose.getGlobalMatrices();
+			 updatePalette();
 
 			 // [CA] To do: Update objectTransform with the track information
 			 for (unsigned int i = 0; i < meshes.size(); i++) {
-				 meshes[i].CPUSkin(skeleton, animInfo.animatedPose);
+				 if (dualQuaternionSkinning) {
+					 meshes[i].CPUSkin(animInfo.dqPalette, *skinningPool);
+				 }
+				 else {
+					 meshes[i].CPUSkin(animInfo.posePalette, *skinningPool);
+				 }
 				 meshes[i].updateOpenGLBuffers();
 			 }
 			break;
@@ -238,14 +276,14 @@ void Lab3::update(float inDeltaTime) {
 		 case TASK4:
 		 {
 			 // [CA] To do: Sample YOUR CLIP
-			 animInfo.playback = clips[animInfo.clip].sample(animInfo.animatedPose, currentTime);
+			 animInfo.playback = fastClips[animInfo.clip].sample(animInfo.animatedPose, currentTime, &animInfo.cursor);
 
 			 // [CA] To do: Update the addPose using the additiveTime and apply additive blending (remember that our blend root index is -1)
 			 addPose = clip.sample(animInfo.animatedPose, additiveTime);
 			 add(animInfo.animatedPose, animInfo.animatedPose, addPose, additiveBase, -1);
 
-			 // [CA] To do: Update poseMatrices the animInfo
-			 animInfo.poseMatrices = animInfo.animatedPose.getGlobalMatrices();
+			 // [CA] To do: Update the palette of the animInfo
+			 updatePalette();
 			 break;
 		 }
 		default:
@@ -278,6 +316,7 @@ void Lab3::ImGui(nk_context* context) {
 		nk_layout_row_static(context, 25, 200, 1);
 		nk_checkbox_label(context, "Show axes", &showAxes);
 		nk_checkbox_label(context, "Show skeleton", &showSkeleton);
+		nk_checkbox_label(context, "Dual quaternion skinning", &dualQuaternionSkinning);
 		currentTask = nk_combo(context, tasks, NK_LEN(tasks), currentTask, 25, nk_vec2(200, 200));
 		nk_layout_row_static(context, 25, 200, 1);
 
@@ -298,67 +337,67 @@ void Lab3::ImGui(nk_context* context) {
 					selectedFrame = nk_combo(context, frameIndex, track.size(), selectedFrame, 25, nk_vec2(200, 200));
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Slope in", NK_TEXT_CENTERED);
-					nk_property_float(context, "#in.x", -10, &track[selectedFrame].in[0], 10, 0.1, 0.1);
-					nk_property_float(context, "#in.y", -10, &track[selectedFrame].in[1], 10, 0.1, 0.1);
-					nk_property_float(context, "#in.z", -10, &track[selectedFrame].in[2], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.x", -10, &track.getInTangent(selectedFrame)[0], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.y", -10, &track.getInTangent(selectedFrame)[1], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.z", -10, &track.getInTangent(selectedFrame)[2], 10, 0.1, 0.1);
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Slope out", NK_TEXT_CENTERED);
-					nk_property_float(context, "#out.x", -10, &track[selectedFrame].out[0], 10, 0.1, 0.1);
-					nk_property_float(context, "#out.y", -10, &track[selectedFrame].out[1], 10, 0.1, 0.1);
-					nk_property_float(context, "#out.z", -10, &track[selectedFrame].out[2], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.x", -10, &track.getOutTangent(selectedFrame)[0], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.y", -10, &track.getOutTangent(selectedFrame)[1], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.z", -10, &track.getOutTangent(selectedFrame)[2], 10, 0.1, 0.1);
 				}
 				break;
 			case TASK3:
 				interpolationType = nk_combo(context, interpolation, 3, interpolationType, 25, nk_vec2(200, 200));
 				if (interpolationType == 0)
 				{
-					clip[13].getRotationTrack().setInterpolation(Interpolation::Constant);
-					clip[24].getRotationTrack().setInterpolation(Interpolation::Constant);
+					clip[leftArmJoint].getRotationTrack().setInterpolation(Interpolation::Constant);
+					clip[rightForeArmJoint].getRotationTrack().setInterpolation(Interpolation::Constant);
 				}
 				if (interpolationType == 1)
 				{
-					clip[13].getRotationTrack().setInterpolation(Interpolation::Linear);
-					clip[24].getRotationTrack().setInterpolation(Interpolation::Linear);
+					clip[leftArmJoint].getRotationTrack().setInterpolation(Interpolation::Linear);
+					clip[rightForeArmJoint].getRotationTrack().setInterpolation(Interpolation::Linear);
 				}
 				if (interpolationType == 2)
 				{
-					clip[13].getRotationTrack().setInterpolation(Interpolation::Cubic);
+					clip[leftArmJoint].getRotationTrack().setInterpolation(Interpolation::Cubic);
 
 					const char* frameIndex[] = { "1", "2", "3"}; // [CA] To do: update with the n� of frames of the track you created
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Edit track slopes", NK_TEXT_CENTERED);
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Frame", NK_TEXT_CENTERED);
-					selectedFrame = nk_combo(context, frameIndex, clip[13].getRotationTrack().size(), selectedFrame, 25, nk_vec2(200, 200));
+					selectedFrame = nk_combo(context, frameIndex, clip[leftArmJoint].getRotationTrack().size(), selectedFrame, 25, nk_vec2(200, 200));
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Slope in", NK_TEXT_CENTERED);
-					nk_property_float(context, "#in.x", -10, &clip[13].getRotationTrack()[selectedFrame].in[0], 10, 0.1, 0.1);
-					nk_property_float(context, "#in.y", -10, &clip[13].getRotationTrack()[selectedFrame].in[1], 10, 0.1, 0.1);
-					nk_property_float(context, "#in.z", -10, &clip[13].getRotationTrack()[selectedFrame].in[2], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.x", -10, &clip[leftArmJoint].getRotationTrack().getInTangent(selectedFrame)[0], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.y", -10, &clip[leftArmJoint].getRotationTrack().getInTangent(selectedFrame)[1], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.z", -10, &clip[leftArmJoint].getRotationTrack().getInTangent(selectedFrame)[2], 10, 0.1, 0.1);
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Slope out", NK_TEXT_CENTERED);
-					nk_property_float(context, "#out.x", -10, &clip[13].getRotationTrack()[selectedFrame].out[0], 10, 0.1, 0.1);
-					nk_property_float(context, "#out.y", -10, &clip[13].getRotationTrack()[selectedFrame].out[1], 10, 0.1, 0.1);
-					nk_property_float(context, "#out.z", -10, &clip[13].getRotationTrack()[selectedFrame].out[2], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.x", -10, &clip[leftArmJoint].getRotationTrack().getOutTangent(selectedFrame)[0], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.y", -10, &clip[leftArmJoint].getRotationTrack().getOutTangent(selectedFrame)[1], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.z", -10, &clip[leftArmJoint].getRotationTrack().getOutTangent(selectedFrame)[2], 10, 0.1, 0.1);
 
-					clip[24].getRotationTrack().setInterpolation(Interpolation::Cubic);
+					clip[rightForeArmJoint].getRotationTrack().setInterpolation(Interpolation::Cubic);
 					
 					const char* frameIndex2[] = { "1", "2", "3"}; // [CA] To do: update with the n� of frames of the track you created
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Edit track slopes", NK_TEXT_CENTERED);
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Frame", NK_TEXT_CENTERED);
-					selectedFrame = nk_combo(context, frameIndex2, clip[24].getRotationTrack().size(), selectedFrame, 25, nk_vec2(200, 200));
+					selectedFrame = nk_combo(context, frameIndex2, clip[rightForeArmJoint].getRotationTrack().size(), selectedFrame, 25, nk_vec2(200, 200));
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Slope in", NK_TEXT_CENTERED);
-					nk_property_float(context, "#in.x", -10, &clip[24].getRotationTrack()[selectedFrame].in[0], 10, 0.1, 0.1);
-					nk_property_float(context, "#in.y", -10, &clip[24].getRotationTrack()[selectedFrame].in[1], 10, 0.1, 0.1);
-					nk_property_float(context, "#in.z", -10, &clip[24].getRotationTrack()[selectedFrame].in[2], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.x", -10, &clip[rightForeArmJoint].getRotationTrack().getInTangent(selectedFrame)[0], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.y", -10, &clip[rightForeArmJoint].getRotationTrack().getInTangent(selectedFrame)[1], 10, 0.1, 0.1);
+					nk_property_float(context, "#in.z", -10, &clip[rightForeArmJoint].getRotationTrack().getInTangent(selectedFrame)[2], 10, 0.1, 0.1);
 					nk_layout_row_static(context, 25, 200, 1);
 					nk_label(context, "Slope out", NK_TEXT_CENTERED);
-					nk_property_float(context, "#out.x", -10, &clip[24].getRotationTrack()[selectedFrame].out[0], 10, 0.1, 0.1);
-					nk_property_float(context, "#out.y", -10, &clip[24].getRotationTrack()[selectedFrame].out[1], 10, 0.1, 0.1);
-					nk_property_float(context, "#out.z", -10, &clip[24].getRotationTrack()[selectedFrame].out[2], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.x", -10, &clip[rightForeArmJoint].getRotationTrack().getOutTangent(selectedFrame)[0], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.y", -10, &clip[rightForeArmJoint].getRotationTrack().getOutTangent(selectedFrame)[1], 10, 0.1, 0.1);
+					nk_property_float(context, "#out.z", -10, &clip[rightForeArmJoint].getRotationTrack().getOutTangent(selectedFrame)[2], 10, 0.1, 0.1);
 				}
 				break;
 			case TASK4:
@@ -376,6 +415,21 @@ void Lab3::shutdown() {
 	delete mUpAxis;
 	delete mRightAxis;
 	delete mForwardAxis;
+	delete skinningPool;
+	delete dqShader;
+}
+
+// Only the palette of the current skinning: the dual quaternions for the shader and the CPU skinning, or the packed matrices for
+// the shader and the full ones for the CPU skinning of the tasks 1 to 3
+void Lab3::updatePalette() {
+	if (dualQuaternionSkinning) {
+		skeleton.getDualQuaternionPalette(animInfo.animatedPose, animInfo.dqPalette);
+		return;
+	}
+	skeleton.getSkinPalette(animInfo.animatedPose, animInfo.packedPalette);
+	if (currentTask != TASK4) {
+		skeleton.getSkinPalette(animInfo.animatedPose, animInfo.posePalette);
+	}
 }
 
 void Lab3::onKeyDown(int key, int scancode) {
@@ -388,6 +442,40 @@ void Lab3::onKeyDown(int key, int scancode) {
 	case GLFW_KEY_T:
 		std::cout << "T pressed" << std::endl;
 		break;
+
+	case GLFW_KEY_R: // prints the constant channels removed from the clips when they were loaded
+		for (unsigned int i = 0, size = (unsigned int)clips.size(); i < size; ++i) {
+			printConstantChannelsReport(clips[i].getName(), constantChannels[i]);
+		}
+		break;
+
+	case GLFW_KEY_C: { // compresses the current clip and prints the error of every joint
+		CompressionSettings settings;
+		CompressedClip compressed = compressClip(clips[animInfo.clip], skeleton, settings);
+		printCompressionReport(clips[animInfo.clip], compressed, skeleton, settings);
+		break;
+	}
+
+	case GLFW_KEY_B: // prints the vertices per second of the CPU skinning of the current pose with 1 to 8 threads, and scalar against AVX2
+		skeleton.getSkinPalette(animInfo.animatedPose, animInfo.posePalette); // not updated by the dual quaternion skinning nor the task 4
+		printSkinningBenchmark(meshes, animInfo.posePalette);
+		printSIMDSkinningBenchmark(meshes, animInfo.posePalette);
+		break;
+
+	case GLFW_KEY_H: // prints the difference between the baked cubic polynomials and the Hermite basis functions of the current clip
+		printCubicBakeReport(clips[animInfo.clip]);
+		break;
+
+	case GLFW_KEY_O: // prints the speed and the cache misses of the CPU skinning of the current pose with the vertices sorted by joints
+		skeleton.getSkinPalette(animInfo.animatedPose, animInfo.posePalette);
+		printVertexOrderBenchmark(meshes, animInfo.posePalette);
+		break;
+
+	case GLFW_KEY_Q: // prints the difference between the dual quaternion and the linear blend skinning of every mesh on rigid poses
+		for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+			printDualQuaternionSkinningCheck(skeleton, meshes[i].getPositions(), meshes[i].getNormals(), meshes[i].getWeights(), meshes[i].getInfluences());
+		}
+		break;
 	}
 };
 
@@ -13,8 +13,11 @@
 
 struct AnimationInstance {
 	Pose animatedPose;
-	std::vector <mat4> poseMatrices;
+	std::vector <mat4> posePalette; // skin matrices of the animated pose
+	std::vector <mat3x4> packedPalette; // skin matrices of the animated pose without their last row, for the GPU skinning
+	std::vector <dualquat> dqPalette; // skin transforms of the animated pose as dual quaternions
 	unsigned int clip;
+	ClipCursor cursor; // frames of the last sample of the clip (reset when the clip changes)
 	float playback;
 	Transform model;
 
@@ -42,13 +45,18 @@ protected:
 	bool moving = false;
 
 	Shader* shader;
+	Shader* dqShader; // dual quaternion skinning
+	int dualQuaternionSkinning;
 
 	std::vector<Clip> clips;
+	std::vector<FastClip> fastClips; // optimized copies of the clips, used for playback
+	std::vector<ConstantChannelsReport> constantChannels; // channels removed from each clip at load time
 	std::vector<Mesh> meshes;
 	Skeleton skeleton;
 	Texture* tex;
 	AnimationInstance animInfo;
 	float playbackTime;
+	WorkerPool* skinningPool; // threads of the CPU skinning
 
 	// TASK 1 & 2
 	Transform objectTransform;
@@ -59,6 +67,8 @@ protected:
 
 	// TASK 3
 	Clip clip;
+	unsigned int leftArmJoint;
+	unsigned int rightForeArmJoint;
 
 	// TASK 4
 	Pose addPose;
@@ -66,6 +76,9 @@ protected:
 	float additiveTime;
 	unsigned int additiveIndex;
 
+	// skin palette of the animated pose used by the CPU and the GPU skinning
+	void updatePalette();
+
 public:
 	void init();
 	VectorFrame makeVectorFrame(float time, const vec3& in, const vec3& value, const vec3& out);
@@ -58,8 +58,7 @@ void Lab4::init() {
 	shader = new Shader("shaders/skinned.vs", "shaders/texture.fs");
 
 	IKInfo.animatedPose = skeleton.getRestPose();
-	IKInfo.posePalette.resize(skeleton.getRestPose().size());
-	IKInfo.posePalette = IKInfo.animatedPose.getGlobalMatrices();
+	skeleton.getSkinPalette(IKInfo.animatedPose, IKInfo.posePalette);
 
 	// Create chains
 	createChain();
@@ -122,11 +121,32 @@ void Lab4::createChainFromCharacter() {
 	//TASK 3
 	// [CA] To do: Create a chain using joints of the character and assign it to CCD and FABRIK solvers (the origin joint of the chain has to be in global space)
 	
-	std::vector<Transform> chain;
+	// the chain goes from the right shoulder to the right hand, found by name because the joint ids depend on the file
+	IKInfo.animatedPose = skeleton.getRestPose();
+	std::vector<std::string>& jointNames = skeleton.getJointNames();
+	int joint = -1;
+	for (unsigned int i = 0, size = (unsigned int)jointNames.size(); i < size; ++i) {
+		if (jointNames[i] == "RightHand") {
+			joint = (int)i;
+		}
+	}
+	characterChain.clear();
+	while (joint >= 0) {
+		characterChain.insert(characterChain.begin(), (unsigned int)joint);
+		if (jointNames[joint] == "RightShoulder") {
+			break;
+		}
+		joint = IKInfo.animatedPose.getParent(joint);
+	}
+	if (characterChain.empty()) {
+		return;
+	}
 
-	for (int i = 0; i <= charachterjoint; ++i)
+	std::vector<Transform> chain;
+	chain.push_back(IKInfo.animatedPose.getGlobalTransform(characterChain[0]));
+	for (unsigned int i = 1, size = (unsigned int)characterChain.size(); i < size; ++i)
 	{
-		Transform localTransform = skeleton.getRestPose().getLocalTransform(i);
+		Transform localTransform = IKInfo.animatedPose.getLocalTransform(characterChain[i]);
 		chain.push_back(localTransform);
 	}
 	
@@ -134,7 +154,7 @@ void Lab4::createChainFromCharacter() {
 	FABRIKSolver.setChain(chain);
 	
 	// Set the target to the global position of the last joint of the chain
-	target.position = chain.back().position;
+	target.position = IKInfo.animatedPose.getGlobalTransform(characterChain.back()).position;
 	
 	CCDSolver.solve(target);
 	FABRIKSolver.solve(target);
@@ -212,9 +232,8 @@ void Lab4::render(float inAspectRatio) {
 		Uniform<mat4>::Set(shader->GetUniform("view_projection"), view_projection);
 		Uniform<vec3>::Set(shader->GetUniform("light"), vec3(1, 1, 1));
 
-		std::vector<mat4> poseMatrices = IKInfo.animatedPose.getGlobalMatrices();
-		Uniform<mat4>::Set(shader->GetUniform("pose"), poseMatrices);
-		Uniform<mat4>::Set(shader->GetUniform("invBindPose"), skeleton.getInvBindPose());
+		skeleton.getSkinPalette(IKInfo.animatedPose, IKInfo.posePalette);
+		Uniform<mat4>::Set(shader->GetUniform("palette"), IKInfo.posePalette);
 
 		tex->Set(shader->GetUniform("tex0"), 0);
 		for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
@@ -268,6 +287,9 @@ void Lab4::update(float inDeltaTime) {
 	{
 		// [CA] To do:
 		// Solve IK for character chain depending of the selected solver type
+		if (characterChain.empty()) {
+			break; // the skeleton has no joints with the names of the chain
+		}
 
 		if (currentSolver == 0)
 		{
@@ -277,15 +299,19 @@ void Lab4::update(float inDeltaTime) {
 			// Update skeleton and current pose with the IK chain transforms
 			// 1. Get origin joint in local space: Combine the inverse global transformation of its parent with its computed IK transformation
 			Transform originLocalTransform = CCDSolver.getChain()[0];
+			int parent = IKInfo.animatedPose.getParent(characterChain[0]);
+			if (parent >= 0) {
+				originLocalTransform = combine(inverse(IKInfo.animatedPose.getGlobalTransform(parent)), originLocalTransform);
+			}
 
 			// 2. Set the local transformation of the origin joint to the current pose
-			IKInfo.animatedPose.setLocalTransform(0, originLocalTransform);
+			IKInfo.animatedPose.setLocalTransform(characterChain[0], originLocalTransform);
 
 			// 3. For the rest of the chain, set the local transformation of each joint into the corresponding current pose joint
-			for (int i = chainSize - 1; i >= 0; --i)
+			for (int i = chainSize - 1; i >= 1; --i)
 			{
 				Transform jointLocalTransform = CCDSolver.getChain()[i];
-				IKInfo.animatedPose.setLocalTransform(i, jointLocalTransform);
+				IKInfo.animatedPose.setLocalTransform(characterChain[i], jointLocalTransform);
 			}
 
 		}
@@ -299,20 +325,24 @@ void Lab4::update(float inDeltaTime) {
 			// Update skeleton and current pose with the IK chain transforms
 			// 1. Get origin joint in local space: Combine the inverse global transformation of its parent with its computed IK transformation
 			Transform originLocalTransform = FABRIKSolver.getChain()[0];
+			int parent = IKInfo.animatedPose.getParent(characterChain[0]);
+			if (parent >= 0) {
+				originLocalTransform = combine(inverse(IKInfo.animatedPose.getGlobalTransform(parent)), originLocalTransform);
+			}
 
 			// 2. Set the local transformation of the origin joint to the current pose
-			IKInfo.animatedPose.setLocalTransform(0, originLocalTransform);
+			IKInfo.animatedPose.setLocalTransform(characterChain[0], originLocalTransform);
 
 			// 3. For the rest of the chain, set the local transformation of each joint into the corresponding current pose joint
-			for (int i = chainSize - 1; i >= 0; --i)
+			for (int i = chainSize - 1; i >= 1; --i)
 			{
 				Transform jointLocalTransform = FABRIKSolver.getChain()[i];
-				IKInfo.animatedPose.setLocalTransform(i, jointLocalTransform);
+				IKInfo.animatedPose.setLocalTransform(characterChain[i], jointLocalTransform);
 			}
 		}
 		
-		// Update the global matrices of the struct animaiton
-		IKInfo.posePalette = IKInfo.animatedPose.getGlobalMatrices();
+		// Update the skin palette of the struct animaiton
+		skeleton.getSkinPalette(IKInfo.animatedPose, IKInfo.posePalette);
 		
 		// Update the poseHelper visualization with the current pose
 		poseHelper->fromPose(IKInfo.animatedPose);
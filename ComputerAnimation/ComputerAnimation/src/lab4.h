@@ -48,7 +48,7 @@ protected:
 	enum solvers { CCD, FABRIK };
 	static const char* solvers[];
 	int currentSolver;
-	int charachterjoint = 20;
+	std::vector<unsigned int> characterChain; // joints of the character chain, from the origin to the end effector
 
 	IKSolver* currSolver;
 	CCDSolver CCDSolver;
@@ -89,7 +89,7 @@ void Lab5::init() {
 	// [CA] To do: Init the animationInfo instance with the source information (Tip: use the previous labs as reference)
 	animationInfo.animatedPose = sourceGLTF.skeleton.getRestPose();
 	animationInfo.posePalette.resize(sourceGLTF.skeleton.getRestPose().size());
-	animationInfo.posePalette = animationInfo.animatedPose.getGlobalMatrices();
+	animationInfo.animatedPose.getGlobalMatrices(animationInfo.posePalette);
 
 	// [CA] To do: Init the target poses with the target bind pose
 	targetPose = target.skeleton.getBindPose();
@@ -120,7 +120,6 @@ void Lab5::render(float inAspectRatio) {
 
 	camera->setPerspective(camera->fov, inAspectRatio, 0.01f, 1000.0f);
 	mat4 view_projection = camera->getViewProjectionMatrix();
-	std::vector<mat4> poseMatrices;
 	
 	if (currentTask == TASK3) {
 		sourceBVH.skeletonHelper->fromPose(animationInfo.animatedPose);
@@ -138,9 +137,8 @@ void Lab5::render(float inAspectRatio) {
 	{
 		Uniform<mat4>::Set(shader->GetUniform("model"), sourceGLTF.model);
 
-		poseMatrices = animationInfo.posePalette;
-		Uniform<mat4>::Set(shader->GetUniform("pose"), poseMatrices);
-		Uniform<mat4>::Set(shader->GetUniform("invBindPose"), sourceGLTF.skeleton.getInvBindPose());
+		sourceGLTF.skeleton.getSkinPalette(animationInfo.animatedPose, poseMatrices);
+		Uniform<mat4>::Set(shader->GetUniform("palette"), poseMatrices);
 
 		if (showSource)
 		{
@@ -156,15 +154,14 @@ void Lab5::render(float inAspectRatio) {
 	mat4 model_aux1;
 	model_aux1.position.x = +2;
 	if (showBindPose) {
-		poseMatrices = target.skeleton.getBindPose().getGlobalMatrices();
+		target.skeleton.getSkinPalette(target.skeleton.getBindPose(), poseMatrices);
 	}
 	else {
-		poseMatrices = targetPose.getGlobalMatrices();
+		target.skeleton.getSkinPalette(targetPose, poseMatrices);
 	}
 
 		Uniform<mat4>::Set(shader->GetUniform("model"), model_aux1);
-		Uniform<mat4>::Set(shader->GetUniform("pose"), poseMatrices);
-		Uniform<mat4>::Set(shader->GetUniform("invBindPose"), target.skeleton.getInvBindPose());
+		Uniform<mat4>::Set(shader->GetUniform("palette"), poseMatrices);
 	if (showTarget)
 	{
 		for (unsigned int i = 0, size = (unsigned int)target.meshes.size(); i < size; ++i) {
@@ -178,15 +175,14 @@ void Lab5::render(float inAspectRatio) {
 	mat4 model_aux2;
 	model_aux2.position.x = -2;
 	if(showBindPose) {
-		poseMatrices = target.skeleton.getBindPose().getGlobalMatrices();
+		target.skeleton.getSkinPalette(target.skeleton.getBindPose(), poseMatrices);
 	}
 	else {
-		poseMatrices = badTargetPose.getGlobalMatrices();
+		target.skeleton.getSkinPalette(badTargetPose, poseMatrices);
 	}
 
 	Uniform<mat4>::Set(shader->GetUniform("model"), model_aux2);
-	Uniform<mat4>::Set(shader->GetUniform("pose"), poseMatrices);
-	Uniform<mat4>::Set(shader->GetUniform("invBindPose"), target.skeleton.getInvBindPose());
+	Uniform<mat4>::Set(shader->GetUniform("palette"), poseMatrices);
 	if (showBadTarget)
 	{
 		for (unsigned int i = 0, size = (unsigned int)target.meshes.size(); i < size; ++i) {
@@ -256,7 +252,7 @@ void Lab5::update(float inDeltaTime) {
 				// [CA] To do: Sample the (bad) target pose without retargeting		
 				animationInfo.playback = target.clips[animationInfo.clip].sample(badTargetPose, currentTime);
 
-				animationInfo.posePalette = animationInfo.animatedPose.getGlobalMatrices();
+				animationInfo.animatedPose.getGlobalMatrices(animationInfo.posePalette);
 
 			}		
 			else
@@ -280,7 +276,7 @@ void Lab5::update(float inDeltaTime) {
 				retargetingSolver->solve(targetPose);
 				animationInfo.playback = target.clips[animationInfo.clip].sample(targetPose, currentTime);
 
-				animationInfo.posePalette = animationInfo.animatedPose.getGlobalMatrices();
+				animationInfo.animatedPose.getGlobalMatrices(animationInfo.posePalette);
 
 			}
 			else 
@@ -308,7 +304,7 @@ void Lab5::update(float inDeltaTime) {
 				retargetingSolver->solve(targetPose);
 				animationInfo.playback = target.clips[animationInfo.clip].sample(targetPose, currentTime);
 
-				animationInfo.posePalette = animationInfo.animatedPose.getGlobalMatrices();
+				animationInfo.animatedPose.getGlobalMatrices(animationInfo.posePalette);
 			}
 			else 
 			{
@@ -416,6 +412,13 @@ void Lab5::onKeyDown(int key, int scancode) {
 		case GLFW_KEY_T:
 			std::cout << "T pressed" << std::endl;
 			break;
+		case GLFW_KEY_B: { // prints the time to find the frames of the BVH clip with the backward scan, the binary search and the cursors
+			bvh::Bvh data = loadBVHFile("assets/Walk.bvh");
+			Clip walk = loadAnimationClip(data);
+			Pose pose = sourceBVH.skeleton.getRestPose();
+			printFrameSearchBenchmark(walk, pose);
+			break;
+		}
 	}
 };
 
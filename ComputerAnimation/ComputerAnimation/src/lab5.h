@@ -59,6 +59,7 @@ protected:
 
 
 	Shader* shader;
+	std::vector<mat4> poseMatrices; // skin palette of the rendered poses
 	
 	// Source characters
 	Entity sourceGLTF;
@@ -46,6 +46,7 @@ void Lab6::init() {
 	cgltf_data* gltf = loadGLTFFile("assets/Eva_Low.glb"); // parse the data of the specified file path
 	entity.skeleton = loadSkeleton(gltf);
 	entity.pose = entity.skeleton.getRestPose();
+	entity.pose.setGlobalCacheEnabled(true); // the gaze and the skeleton helper read the global transforms between edits
 	entity.clips = loadAnimationClips(gltf);
 	entity.meshes = loadMeshes(gltf);
 
@@ -75,7 +76,7 @@ void Lab6::init() {
 	freeGLTFFile(gltf);
 	
 	// Load shaders to render the meshes
-	shader = new Shader("shaders/morph.vs", "shaders/pbr.fs");
+	shader = new Shader("shaders/morph_3x4.vs", "shaders/pbr.fs");
 	
 	// Set current task
 	currentTask = TASK1;
@@ -225,17 +226,15 @@ void Lab6::render(float inAspectRatio) {
 	Uniform<vec3>::Set(shader->GetUniform("ambientLight"), vec3(0.04));
 	
 	// Send data for skinning
-	std::vector<mat4> poseMatrices;
 	if (showBindPose) {
-		poseMatrices = entity.skeleton.getBindPose().getGlobalMatrices();
+		entity.skeleton.getSkinPalette(entity.skeleton.getBindPose(), poseMatrices);
 	}
 	else {
-		poseMatrices = entity.pose.getGlobalMatrices(); 
+		entity.skeleton.getSkinPalette(entity.pose, poseMatrices);
 	}
 
 	Uniform<mat4>::Set(shader->GetUniform("model"), entity.model);
-	Uniform<mat4>::Set(shader->GetUniform("pose"), poseMatrices);
-	Uniform<mat4>::Set(shader->GetUniform("invBindPose"), entity.skeleton.getInvBindPose());
+	Uniform<mat3x4>::Set(shader->GetUniform("palette"), poseMatrices);
 
 	// Render each mesh of the entity
 	for (unsigned int i = 0, size = (unsigned int)entity.meshes.size(); i < size; ++i) {
@@ -495,7 +494,7 @@ void Lab6::ImGui(nk_context* context) {
 			// Set the bind pose as current pose
 			
 			entity.pose = entity.skeleton.getRestPose();
-			
+			entity.pose.setGlobalCacheEnabled(true);
 		}
 
 		if (currentTask == TASK1) {
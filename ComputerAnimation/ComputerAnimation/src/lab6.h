@@ -63,6 +63,7 @@ protected:
     bool activeScroll = true;
 
 	Shader* shader;
+	std::vector<mat3x4> poseMatrices; // skin palette of the rendered pose, packed without the last row of the matrices
 	
 	// Source characters
 	Entity entity;
@@ -43,7 +43,7 @@ std::vector<std::string> loadJointNames(const bvh::Bvh data) {
 	return jointNames;
 }
 
-Clip loadAnimationClip(const bvh::Bvh data) {
+Clip loadAnimationClip(const bvh::Bvh data, const KeyReductionOptions& options) {
 	Clip clip;
 	unsigned int numFrames = data.numFrames();
 	for (int i = 0; i < data.joints().size(); i++) {
@@ -135,6 +135,10 @@ Clip loadAnimationClip(const bvh::Bvh data) {
 			time += data.frameTime();
 		}
 	}
+	if (options.enabled) {
+		printKeyReductionReport(clip.getName(), reduceKeys(clip, options));
+	}
+	clip.shareTimelines(); // all the channels have the times of the frames of the file
 	clip.recalculateDuration();
 	return clip;
 }
\ No newline at end of file
@@ -11,4 +11,5 @@ bvh::Bvh loadBVHFile(const char* path);
 Pose loadRestPose(const bvh::Bvh data);
 std::vector<std::string> loadJointNames(const bvh::Bvh data);
 Skeleton loadSkeleton(const bvh::Bvh data);
-Clip loadAnimationClip(const bvh::Bvh data);
\ No newline at end of file
+// the frames of the clip can be reduced within the tolerances of the options (opt-in)
+Clip loadAnimationClip(const bvh::Bvh data, const KeyReductionOptions& options = KeyReductionOptions());
\ No newline at end of file
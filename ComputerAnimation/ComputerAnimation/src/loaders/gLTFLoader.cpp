@@ -40,18 +40,56 @@ void freeGLTFFile(cgltf_data* data) {
 	}
 }
 
+GLTFJointMap loadJointMap(const cgltf_data* data) {
+	unsigned int numNodes = (unsigned int)data->nodes_count;
+	std::vector<bool> isJoint(numNodes, false);
+
+	// the joints of the skins and the nodes moved by the animations
+	for (unsigned int i = 0; i < data->skins_count; ++i) {
+		cgltf_skin* skin = &(data->skins[i]);
+		for (unsigned int j = 0; j < skin->joints_count; ++j) {
+			GLTFHelpers::markJoint(skin->joints[j], data, isJoint);
+		}
+	}
+	for (unsigned int i = 0; i < data->animations_count; ++i) {
+		cgltf_animation* animation = &(data->animations[i]);
+		for (unsigned int j = 0; j < animation->channels_count; ++j) {
+			cgltf_animation_channel& channel = animation->channels[j];
+			// the weights of the morph targets don't move the node
+			if (channel.target_path == cgltf_animation_path_type_translation || channel.target_path == cgltf_animation_path_type_rotation
+				|| channel.target_path == cgltf_animation_path_type_scale) {
+				GLTFHelpers::markJoint(channel.target_node, data, isJoint);
+			}
+		}
+	}
+
+	// depth first from the roots, so that the parents come before their children
+	GLTFJointMap result;
+	result.nodeToJoint.resize(numNodes, -1);
+	for (unsigned int i = 0; i < numNodes; ++i) {
+		if (data->nodes[i].parent == 0) {
+			GLTFHelpers::addJoints(&(data->nodes[i]), data, isJoint, result);
+		}
+	}
+	return result;
+}
+
 Pose loadRestPose(const cgltf_data* data) {
-	unsigned int numBones = data->nodes_count;
+	return loadRestPose(data, loadJointMap(data));
+}
+
+Pose loadRestPose(const cgltf_data* data, const GLTFJointMap& joints) {
+	unsigned int numBones = (unsigned int)joints.jointToNode.size();
 	Pose restPose(numBones);
 
 	for (unsigned int i = 0; i < numBones; i++) {
-		cgltf_node* node = &(data->nodes[i]);
+		cgltf_node* node = &(data->nodes[joints.jointToNode[i]]);
 		//get local transform
-		Transform transform = GLTFHelpers::getLocalTransform(data->nodes[i]);
+		Transform transform = GLTFHelpers::getLocalTransform(*node);
 		//assign the local transform to the pose's joint
 		restPose.setLocalTransform(i, transform);
-		//get parent node index
-		int parentId = GLTFHelpers::getNodeIndex(node->parent, data->nodes, numBones);
+		//get parent joint index (the parents of the joints are joints too)
+		int parentId = GLTFHelpers::getJointIndex(node->parent, data, joints);
 		//set the parennt to the pose joint
 		restPose.setParent(i, parentId);
 	}
@@ -59,14 +97,16 @@ Pose loadRestPose(const cgltf_data* data) {
 }
 
 Pose loadBindPose(const cgltf_data* data) {
-	Pose restPose = loadRestPose(data);
+	return loadBindPose(data, loadJointMap(data));
+}
+
+Pose loadBindPose(const cgltf_data* data, const GLTFJointMap& joints) {
+	Pose restPose = loadRestPose(data, joints);
 
 	unsigned int numBones = restPose.size();
-	std::vector<Transform> worldBindPose(numBones);
 	// initialize the array of the world transforms with the transforms of the rest pose
-	for (unsigned int i = 0; i < numBones; i++) {
-		worldBindPose[i] = restPose.getGlobalTransform(i);
-	}
+	std::vector<Transform> worldBindPose;
+	restPose.getGlobalTransforms(worldBindPose);
 
 	//get number of skins (skinned meshes)
 	unsigned int numSkins = data->skins_count;
@@ -86,8 +126,7 @@ Pose loadBindPose(const cgltf_data* data) {
 			mat4 bindMatrix = inverse(invBindMatrix);
 			Transform bindTransform = mat4ToTransform(bindMatrix);
 			//set the transform into the array of transforms of the joints in the bind pose (world bind pose)
-			cgltf_node* jointNode = skin->joints[j];
-			int jointIndex = GLTFHelpers::getNodeIndex(jointNode, data->nodes, numBones);
+			int jointIndex = GLTFHelpers::getJointIndex(skin->joints[j], data, joints);
 			worldBindPose[jointIndex] = bindTransform;
 		}
 	}
@@ -108,10 +147,14 @@ Pose loadBindPose(const cgltf_data* data) {
 
 //loads the names of every joint in the same order that the joints for the rest pose were loaded
 std::vector<std::string> loadJointNames(const cgltf_data* data) {
-	unsigned int numBones = (unsigned int)data->nodes_count;
+	return loadJointNames(data, loadJointMap(data));
+}
+
+std::vector<std::string> loadJointNames(const cgltf_data* data, const GLTFJointMap& joints) {
+	unsigned int numBones = (unsigned int)joints.jointToNode.size();
 	std::vector<std::string> result(numBones, "Not Set");
 	for (unsigned int i = 0; i < numBones; ++i) {
-		cgltf_node* node = &(data->nodes[i]);
+		cgltf_node* node = &(data->nodes[joints.jointToNode[i]]);
 		if (node->name == 0) {
 			result[i] = "EMPTY NODE";
 		}
@@ -123,14 +166,16 @@ std::vector<std::string> loadJointNames(const cgltf_data* data) {
 }
 
 Skeleton loadSkeleton(const cgltf_data* data) {
+	GLTFJointMap joints = loadJointMap(data);
 	return Skeleton(
-		loadRestPose(data),
-		loadBindPose(data),
-		loadJointNames(data)
+		loadRestPose(data, joints),
+		loadBindPose(data, joints),
+		loadJointNames(data, joints)
 	);
 }
 
 std::vector<Mesh> loadMeshes(const cgltf_data* data) {
+	GLTFJointMap joints = loadJointMap(data);
 	std::vector<Mesh> result;
 	std::vector<std::vector<MorphTarget> > morphTargets;
 	
@@ -144,6 +189,15 @@ std::vector<Mesh> loadMeshes(const cgltf_data* data) {
 			continue;
 		}
 
+		// joint of the skeleton of every joint of the skin, for the influences
+		std::vector<int> skinJoints;
+		if (node->skin != 0) {
+			skinJoints.resize(node->skin->joints_count);
+			for (unsigned int j = 0; j < node->skin->joints_count; ++j) {
+				skinJoints[j] = GLTFHelpers::getJointIndex(node->skin->joints[j], data, joints);
+			}
+		}
+
 		int numPrims = node->mesh->primitives_count;
 		for (int j = 0; j < numPrims; ++j) {
 
@@ -160,7 +214,7 @@ std::vector<Mesh> loadMeshes(const cgltf_data* data) {
 			unsigned int ac = primitive->attributes_count;
 			for (unsigned int k = 0; k < ac; ++k) {
 				cgltf_attribute* attribute = &primitive->attributes[k];
-				GLTFHelpers::meshFromAttribute(mesh, *attribute, node->skin, nodes, nodeCount);
+				GLTFHelpers::meshFromAttribute(mesh, *attribute, skinJoints);
 
 				// If the primitive has indices, the index buffer of the mesh needs to be filled out
 				if (primitive->indices != 0) {
@@ -192,6 +246,11 @@ std::vector<Mesh> loadMeshes(const cgltf_data* data) {
 				mesh.morphTargetNames = names;
 			}
 
+			// Group the vertices by influence count for the CPU skinning
+			if (node->skin != 0) {
+				mesh.sortByInfluenceCount();
+			}
+
 			// For render the mesh
 			mesh.updateOpenGLBuffers();
 		}
@@ -202,9 +261,9 @@ std::vector<Mesh> loadMeshes(const cgltf_data* data) {
 }
 
 
-std::vector<Clip> loadAnimationClips(cgltf_data* data) {
+std::vector<Clip> loadAnimationClips(cgltf_data* data, const KeyReductionOptions& options) {
 	unsigned int nuclips = data->animations_count;
-	unsigned int numNodes = data->nodes_count;
+	GLTFJointMap joints = loadJointMap(data);
 
 	std::vector<Clip> result;
 	result.resize(nuclips);
@@ -219,8 +278,8 @@ std::vector<Clip> loadAnimationClips(cgltf_data* data) {
 			cgltf_animation_channel& channel = data->animations[i].channels[j];
 			cgltf_node* target = channel.target_node;
 
-			// find the index of the node that the current channel affects
-			int nodeId = GLTFHelpers::getNodeIndex(target, data->nodes, numNodes);
+			// find the index of the joint that the current channel affects
+			int nodeId = GLTFHelpers::getJointIndex(target, data, joints);
 			if (channel.target_path == cgltf_animation_path_type_translation) {
 				VectorTrack& track = result[i][nodeId].getPositionTrack();
 				// convert the track into an animation track
@@ -237,6 +296,10 @@ std::vector<Clip> loadAnimationClips(cgltf_data* data) {
 				GLTFHelpers::trackFromChannel<quat, 4>(track, channel);
 			}
 		} // End num channels loop
+		if (options.enabled) {
+			printKeyReductionReport(result[i].getName(), reduceKeys(result[i], options));
+		}
+		result[i].shareTimelines(); // the channels often share the input accessor of their samplers
 		result[i].recalculateDuration();
 	} // End num clips loop
 
@@ -267,15 +330,38 @@ Transform GLTFHelpers::getLocalTransform(cgltf_node& n) {
 
 //Gets the node index given all the nodes
 int GLTFHelpers::getNodeIndex(cgltf_node* node, cgltf_node* allNodes, unsigned int numNodes) {
-	if (node == 0) {
+	if (node == 0 || node < allNodes || node >= allNodes + numNodes) {
 		return -1;
 	}
-	for (unsigned int i = 0; i < numNodes; ++i) {
-		if (node == &allNodes[i]) {
-			return (int)i;
-		}
+	return (int)(node - allNodes);
+}
+
+//Gets the joint index of a node, -1 if the node isn't a joint
+int GLTFHelpers::getJointIndex(cgltf_node* node, const cgltf_data* data, const GLTFJointMap& joints) {
+	int nodeIndex = getNodeIndex(node, data->nodes, (unsigned int)data->nodes_count);
+	return nodeIndex < 0 ? -1 : joints.nodeToJoint[nodeIndex];
+}
+
+//Marks the node and its parents as joints (the parents are needed for the global transform of the node)
+void GLTFHelpers::markJoint(cgltf_node* node, const cgltf_data* data, std::vector<bool>& isJoint) {
+	for (int i = getNodeIndex(node, data->nodes, (unsigned int)data->nodes_count); i >= 0 && !isJoint[i];
+		i = getNodeIndex(data->nodes[i].parent, data->nodes, (unsigned int)data->nodes_count)) {
+		isJoint[i] = true;
+	}
+}
+
+//Adds the joints of the hierarchy of the node to the joint map, the node before its children
+void GLTFHelpers::addJoints(cgltf_node* node, const cgltf_data* data, const std::vector<bool>& isJoint, GLTFJointMap& joints) {
+	int nodeIndex = getNodeIndex(node, data->nodes, (unsigned int)data->nodes_count);
+	// the parents of the joints are joints, so nothing below a node that isn't a joint is a joint
+	if (nodeIndex < 0 || !isJoint[nodeIndex]) {
+		return;
+	}
+	joints.nodeToJoint[nodeIndex] = (int)joints.jointToNode.size();
+	joints.jointToNode.push_back((unsigned int)nodeIndex);
+	for (unsigned int i = 0; i < node->children_count; ++i) {
+		addJoints(node->children[i], data, isJoint, joints);
 	}
-	return -1;
 }
 
 //Reads the floating-point values of a gltf accessor and put them into a vector of floats
@@ -291,7 +377,7 @@ It takes a mesh and a cgltf_attribute function, along with some additional data
 The attribute contains one of our mesh components, such as the position, normal, UV coordinate, weights, or influences.
 This attribute provides the appropriate mesh data
 */
-void GLTFHelpers::meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, cgltf_skin* skin, cgltf_node* nodes, unsigned int nodeCount) {
+void GLTFHelpers::meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, const std::vector<int>& skinJoints) {
 	cgltf_attribute_type attribType = attribute.type;
 	cgltf_accessor& accessor = *attribute.data;
 
@@ -315,6 +401,7 @@ void GLTFHelpers::meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, c
 	//Create references to the position, normal, texture coordinate, influences, and weights vectors of the mesh
 	std::vector<vec3>& positions = outMesh.getPositions();
 	std::vector<vec3>& normals = outMesh.getNormals();
+	std::vector<vec4>& tangents = outMesh.getTangents();
 	std::vector<vec2>& texCoords = outMesh.getTexCoords();
 	std::vector<ivec4>& influences = outMesh.getInfluences();
 	std::vector<vec4>& weights = outMesh.getWeights();
@@ -339,6 +426,10 @@ void GLTFHelpers::meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, c
 		}
 		break;
 
+		case cgltf_attribute_type_tangent:
+			tangents.push_back(vec4(values[index + 0], values[index + 1], values[index + 2], values[index + 3]));
+			break;
+
 		case cgltf_attribute_type_texcoord:
 			texCoords.push_back(vec2(values[index + 0], values[index + 1]));
 			break;
@@ -360,10 +451,9 @@ void GLTFHelpers::meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, c
 			);
 
 			// convert the joint indices so that they go from being relative to the joints array to being relative to the skeleton hierarchy
-			joints.x = getNodeIndex(skin->joints[joints.x], nodes, nodeCount);
-			joints.y = getNodeIndex(skin->joints[joints.y], nodes, nodeCount);
-			joints.z = getNodeIndex(skin->joints[joints.z], nodes, nodeCount);
-			joints.w = getNodeIndex(skin->joints[joints.w], nodes, nodeCount);
+			for (int c = 0; c < 4; ++c) {
+				joints.v[c] = joints.v[c] >= 0 && joints.v[c] < (int)skinJoints.size() ? skinJoints[joints.v[c]] : -1;
+			}
 
 			//Make sure that even the invalid nodes have a value of 0 (any negative joint indices will break the skinning implementation)
 			joints.x = std::max(0, joints.x);
@@ -554,7 +644,7 @@ void GLTFHelpers::trackFromChannel(Track<T, N>& result, const cgltf_animation_ch
 	// parse the time and value arrays into frame structures
 	for (unsigned int i = 0; i < numFrames; ++i) {
 		int baseIndex = i * compCount;
-		Frame<N>& frame = result[i];
+		Frame<N> frame;
 		// offset used to deal with cubic tracks since the input and output tangents are as large as the number of components
 		int offset = 0;
 
@@ -575,5 +665,10 @@ void GLTFHelpers::trackFromChannel(Track<T, N>& result, const cgltf_animation_ch
 			frame.out[comp] = isSamplerCubic ?
 				val[baseIndex + offset++] : 0.0f;
 		}
+		result[i] = frame;
+	}
+	// cubic splines are evaluated from precomputed polynomials during playback
+	if (isSamplerCubic) {
+		result.bakeCubic();
 	}
 }
\ No newline at end of file
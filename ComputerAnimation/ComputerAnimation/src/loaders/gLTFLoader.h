@@ -5,20 +5,37 @@
 #include "../shading/mesh.h"
 #include "../animation/clip.h"
 
+// Joints of the skeleton of a glTF file: the nodes of the skins and the nodes moved by the animations (with their parents),
+// in depth first order so that the parents come before their children. Meshes, cameras and the other nodes aren't joints.
+struct GLTFJointMap {
+	std::vector<int> nodeToJoint; // joint index of every node, -1 if the node isn't a joint
+	std::vector<unsigned int> jointToNode; // node index of every joint
+};
+
 cgltf_data* loadGLTFFile(const char* path);
 void freeGLTFFile(cgltf_data* data);
+GLTFJointMap loadJointMap(const cgltf_data* data);
+// the poses, names, clips and meshes of a file use the joint indices of its joint map
 Pose loadRestPose(const cgltf_data* data);
+Pose loadRestPose(const cgltf_data* data, const GLTFJointMap& joints);
 Pose loadBindPose(const cgltf_data* data);
+Pose loadBindPose(const cgltf_data* data, const GLTFJointMap& joints);
 std::vector<std::string> loadJointNames(const cgltf_data* data); 
+std::vector<std::string> loadJointNames(const cgltf_data* data, const GLTFJointMap& joints);
 Skeleton loadSkeleton(const cgltf_data* data);
 std::vector<Mesh> loadMeshes(const cgltf_data* data);
-std::vector<Clip> loadAnimationClips(cgltf_data* data);
+// the frames of the clips can be reduced within the tolerances of the options (opt-in)
+std::vector<Clip> loadAnimationClips(cgltf_data* data, const KeyReductionOptions& options = KeyReductionOptions());
 
 namespace GLTFHelpers {
 	Transform getLocalTransform(cgltf_node& node);
 	int getNodeIndex(cgltf_node* target, cgltf_node* allNodes, unsigned int numNodes);
+	int getJointIndex(cgltf_node* node, const cgltf_data* data, const GLTFJointMap& joints);
+	void markJoint(cgltf_node* node, const cgltf_data* data, std::vector<bool>& isJoint);
+	void addJoints(cgltf_node* node, const cgltf_data* data, const std::vector<bool>& isJoint, GLTFJointMap& joints);
 	void getScalarValues(std::vector<float>& out, unsigned int compCount, const cgltf_accessor& inAccessor);
-	void meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, cgltf_skin* skin, cgltf_node* nodes, unsigned int nodeCount);
+	// skinJoints has the joint index of every joint of the skin of the mesh
+	void meshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, const std::vector<int>& skinJoints);
 	void morphTargetsFromPimitive(Mesh& outMesh, cgltf_primitive& primitive);
 	void materialFromPimitive(Mesh& outMesh, cgltf_primitive& primitive);
 	void encodeMorphTargets(std::vector<MorphTarget>& morphTargets, Texture& textureData);
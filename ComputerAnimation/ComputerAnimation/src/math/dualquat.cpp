@@ -0,0 +1,87 @@
+#include "dualquat.h"
+#include <math.h>
+
+dualquat operator+(const dualquat& a, const dualquat& b) {
+	return dualquat(a.real + b.real, a.dual + b.dual);
+}
+
+dualquat operator*(const dualquat& dq, float f) {
+	return dualquat(dq.real * f, dq.dual * f);
+}
+
+// (r1 + e d1)(r2 + e d2) = r1 r2 + e (r1 d2 + d1 r2), with the quaternion product of this library (the left one first)
+dualquat operator*(const dualquat& a, const dualquat& b) {
+	return dualquat(a.real * b.real, a.real * b.dual + a.dual * b.real);
+}
+
+bool operator==(const dualquat& a, const dualquat& b) {
+	return a.real == b.real && a.dual == b.dual;
+}
+
+bool operator!=(const dualquat& a, const dualquat& b) {
+	return !(a == b);
+}
+
+float dot(const dualquat& a, const dualquat& b) {
+	return dot(a.real, b.real);
+}
+
+dualquat conjugate(const dualquat& dq) {
+	return dualquat(conjugate(dq.real), conjugate(dq.dual));
+}
+
+dualquat normalized(const dualquat& dq) {
+	float lenSq = dot(dq.real, dq.real);
+	if (lenSq < QUAT_EPSILON) {
+		return dualquat();
+	}
+	float il = 1.0f / sqrtf(lenSq); // il: inverse length
+	return dualquat(dq.real * il, dq.dual * il);
+}
+
+void normalize(dualquat& dq) {
+	dq = normalized(dq);
+}
+
+// dual = translation * rotation / 2, with the translation as a pure quaternion
+dualquat transformToDualQuat(const Transform& t) {
+	quat translation(t.position.x, t.position.y, t.position.z, 0);
+	quat dual = t.rotation * translation * 0.5f;
+	return dualquat(t.rotation, dual);
+}
+
+// translation = 2 * dual * conjugate(rotation)
+Transform dualQuatToTransform(const dualquat& dq) {
+	Transform out;
+	out.rotation = dq.real;
+	quat translation = conjugate(dq.real) * (dq.dual * 2.0f);
+	out.position = vec3(translation.x, translation.y, translation.z);
+	return out;
+}
+
+vec3 transformVector(const dualquat& dq, const vec3& v) {
+	return dq.real * v;
+}
+
+vec3 transformPoint(const dualquat& dq, const vec3& v) {
+	quat translation = conjugate(dq.real) * (dq.dual * 2.0f);
+	return dq.real * v + vec3(translation.x, translation.y, translation.z);
+}
+
+mat4 dualQuatToMat4(const dualquat& dq) {
+	const quat& r = dq.real;
+	const quat& d = dq.dual;
+	float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+	float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+	float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+	// translation = 2 * dual * conjugate(rotation), expanded
+	vec3 t(2.0f * (r.w * d.x - d.w * r.x + r.y * d.z - r.z * d.y),
+		2.0f * (r.w * d.y - d.w * r.y + r.z * d.x - r.x * d.z),
+		2.0f * (r.w * d.z - d.w * r.z + r.x * d.y - r.y * d.x));
+	return mat4(
+		1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0,
+		2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0,
+		2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0,
+		t.x, t.y, t.z, 1
+	);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vec3.h"
+#include "quat.h"
+#include "transform.h"
+
+// Rigid transform (rotation and translation, without scale) as a dual quaternion: the real part is the rotation and the
+// dual part is half the translation multiplied by the rotation. 8 floats instead of the 16 of a matrix
+struct dualquat {
+	quat real;
+	quat dual;
+	inline dualquat() :
+		real(0, 0, 0, 1), dual(0, 0, 0, 0) { }
+	inline dualquat(const quat& r, const quat& d) :
+		real(r), dual(d) { }
+};
+
+dualquat operator+(const dualquat& a, const dualquat& b);
+dualquat operator*(const dualquat& dq, float f);
+// Same order as the quaternions: the left transform is applied first
+dualquat operator*(const dualquat& a, const dualquat& b);
+bool operator==(const dualquat& a, const dualquat& b);
+bool operator!=(const dualquat& a, const dualquat& b);
+
+// dot product of the rotations (negative if they are in opposite hemispheres)
+float dot(const dualquat& a, const dualquat& b);
+dualquat conjugate(const dualquat& dq);
+// a sum of weighted dual quaternions is a rigid transform again after dividing it by the length of its rotation
+dualquat normalized(const dualquat& dq);
+void normalize(dualquat& dq);
+
+// the scale of the transform is lost
+dualquat transformToDualQuat(const Transform& t);
+Transform dualQuatToTransform(const dualquat& dq);
+vec3 transformVector(const dualquat& dq, const vec3& v);
+vec3 transformPoint(const dualquat& dq, const vec3& v);
+// rotation and translation matrix of a unit dual quaternion
+mat4 dualQuatToMat4(const dualquat& dq);
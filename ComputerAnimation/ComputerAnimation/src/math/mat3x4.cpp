@@ -0,0 +1,35 @@
+#include "mat3x4.h"
+
+mat3x4 toMat3x4(const mat4& m) {
+	return mat3x4(
+		m.r0c0, m.r0c1, m.r0c2, m.r0c3,
+		m.r1c0, m.r1c1, m.r1c2, m.r1c3,
+		m.r2c0, m.r2c1, m.r2c2, m.r2c3
+	);
+}
+
+mat4 toMat4(const mat3x4& m) {
+	// the mat4 constructor takes the columns
+	return mat4(
+		m.r0c0, m.r1c0, m.r2c0, 0,
+		m.r0c1, m.r1c1, m.r2c1, 0,
+		m.r0c2, m.r1c2, m.r2c2, 0,
+		m.r0c3, m.r1c3, m.r2c3, 1
+	);
+}
+
+vec3 transformVector(const mat3x4& m, const vec3& v) {
+	return vec3(
+		m.r0c0 * v.x + m.r0c1 * v.y + m.r0c2 * v.z,
+		m.r1c0 * v.x + m.r1c1 * v.y + m.r1c2 * v.z,
+		m.r2c0 * v.x + m.r2c1 * v.y + m.r2c2 * v.z
+	);
+}
+
+vec3 transformPoint(const mat3x4& m, const vec3& v) {
+	return vec3(
+		m.r0c0 * v.x + m.r0c1 * v.y + m.r0c2 * v.z + m.r0c3,
+		m.r1c0 * v.x + m.r1c1 * v.y + m.r1c2 * v.z + m.r1c3,
+		m.r2c0 * v.x + m.r2c1 * v.y + m.r2c2 * v.z + m.r2c3
+	);
+}
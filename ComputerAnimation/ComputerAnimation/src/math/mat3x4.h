@@ -0,0 +1,35 @@
+#pragma once
+
+#include "vec3.h"
+#include "mat4.h"
+
+// Affine matrix without its last row, which is always (0, 0, 0, 1), stored row by row. The 3 rows of 4 floats are the
+// 3 columns of a GLSL mat3x4, so a skin palette is uploaded with 12 floats per joint instead of 16
+struct mat3x4 {
+	union {
+		float v[12];
+		struct { // row-column notation
+			float r0c0; float r0c1; float r0c2; float r0c3;
+			float r1c0; float r1c1; float r1c2; float r1c3;
+			float r2c0; float r2c1; float r2c2; float r2c3;
+		};
+	}; // End union
+	inline mat3x4() : // Identity matrix
+		r0c0(1), r0c1(0), r0c2(0), r0c3(0),
+		r1c0(0), r1c1(1), r1c2(0), r1c3(0),
+		r2c0(0), r2c1(0), r2c2(1), r2c3(0) { }
+	inline mat3x4(
+		float _00, float _01, float _02, float _03,
+		float _10, float _11, float _12, float _13,
+		float _20, float _21, float _22, float _23) :
+		r0c0(_00), r0c1(_01), r0c2(_02), r0c3(_03),
+		r1c0(_10), r1c1(_11), r1c2(_12), r1c3(_13),
+		r2c0(_20), r2c1(_21), r2c2(_22), r2c3(_23) { }
+}; // end mat3x4 struct
+
+// drops the last row of the matrix (it has to be (0, 0, 0, 1))
+mat3x4 toMat3x4(const mat4& m);
+mat4 toMat4(const mat3x4& m);
+
+vec3 transformVector(const mat3x4& m, const vec3& v);
+vec3 transformPoint(const mat3x4& m, const vec3& v);
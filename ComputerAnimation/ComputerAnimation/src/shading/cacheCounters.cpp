@@ -0,0 +1,92 @@
+#include "cacheCounters.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#endif
+
+#ifdef __linux__
+namespace CacheCountersHelpers {
+
+	// counter of the event in the calling thread on any CPU, without the kernel code
+	int openEvent(unsigned int type, unsigned long long config) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+
+}; // End CacheCounters helpers namespace
+#endif
+
+CacheCounters::CacheCounters() {
+	for (int e = 0; e < NUM_EVENTS; ++e) {
+		files[e] = -1;
+		counts[e] = 0;
+	}
+#ifdef __linux__
+	files[L1D_READ_MISSES] = CacheCountersHelpers::openEvent(PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+	files[LLC_MISSES] = CacheCountersHelpers::openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+}
+
+CacheCounters::~CacheCounters() {
+#ifdef __linux__
+	for (int e = 0; e < NUM_EVENTS; ++e) {
+		if (files[e] >= 0) {
+			close(files[e]);
+		}
+	}
+#endif
+}
+
+bool CacheCounters::isAvailable() {
+	for (int e = 0; e < NUM_EVENTS; ++e) {
+		if (files[e] >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CacheCounters::isAvailable(Event event) {
+	return files[event] >= 0;
+}
+
+void CacheCounters::start() {
+	for (int e = 0; e < NUM_EVENTS; ++e) {
+		counts[e] = 0;
+#ifdef __linux__
+		if (files[e] >= 0) {
+			ioctl(files[e], PERF_EVENT_IOC_RESET, 0);
+			ioctl(files[e], PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+}
+
+void CacheCounters::stop() {
+#ifdef __linux__
+	for (int e = 0; e < NUM_EVENTS; ++e) {
+		if (files[e] >= 0) {
+			ioctl(files[e], PERF_EVENT_IOC_DISABLE, 0);
+			unsigned long long count = 0;
+			if (read(files[e], &count, sizeof(count)) == (ssize_t)sizeof(count)) {
+				counts[e] = count;
+			}
+		}
+	}
+#endif
+}
+
+unsigned long long CacheCounters::getCount(Event event) {
+	return counts[event];
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Hardware counters of the data cache misses of the calling thread, read with perf_event_open on Linux.
+// On other platforms, or if the kernel doesn't expose the events (virtual machines, perf_event_paranoid),
+// isAvailable is false and the counts stay at 0.
+class CacheCounters {
+public:
+	enum Event {
+		L1D_READ_MISSES = 0, // loads that missed the level 1 data cache
+		LLC_MISSES, // references that missed the last level cache
+		NUM_EVENTS
+	};
+
+protected:
+	int files[NUM_EVENTS]; // perf event file descriptors, -1 if the event couldn't be opened
+	unsigned long long counts[NUM_EVENTS];
+
+	CacheCounters(const CacheCounters&);
+	CacheCounters& operator=(const CacheCounters&);
+public:
+	CacheCounters();
+	~CacheCounters();
+
+	bool isAvailable();
+	bool isAvailable(Event event);
+	// resets and enables the counters
+	void start();
+	// disables the counters and reads their counts
+	void stop();
+	unsigned long long getCount(Event event);
+};
@@ -0,0 +1,101 @@
+#include "dualQuatSkinning.h"
+#include "../math/mat4.h"
+#include "../math/quat.h"
+#include <iostream>
+#include <cmath>
+
+dualquat blendDualQuaternions(const dualquat* palette, const ivec4& joints, const vec4& weights, int count) {
+	dualquat out;
+	const float* real0 = palette[joints.x].real.v;
+	const float* dual0 = palette[joints.x].dual.v;
+	for (int k = 0; k < 4; ++k) {
+		out.real.v[k] = real0[k] * weights.x;
+		out.dual.v[k] = dual0[k] * weights.x;
+	}
+	for (int j = 1; j < count; ++j) {
+		const float* real = palette[joints.v[j]].real.v;
+		const float* dual = palette[joints.v[j]].dual.v;
+		float sign = real0[0] * real[0] + real0[1] * real[1] + real0[2] * real[2] + real0[3] * real[3] < 0.0f ? -1.0f : 1.0f;
+		float w = weights.v[j] * sign;
+		for (int k = 0; k < 4; ++k) {
+			out.real.v[k] += real[k] * w;
+			out.dual.v[k] += dual[k] * w;
+		}
+	}
+	// same as normalized(dualquat), inlined since it runs once per vertex
+	float lenSq = out.real.x * out.real.x + out.real.y * out.real.y + out.real.z * out.real.z + out.real.w * out.real.w;
+	if (lenSq < QUAT_EPSILON) {
+		return dualquat();
+	}
+	float il = 1.0f / sqrtf(lenSq);
+	for (int k = 0; k < 4; ++k) {
+		out.real.v[k] *= il;
+		out.dual.v[k] *= il;
+	}
+	return out;
+}
+
+void skinDualQuaternions(const dualquat* palette, const vec3* positions, const vec3* normals, const vec4* tangents, const vec4* weights, const ivec4* influences,
+	unsigned int oneInfluenceEnd, unsigned int twoInfluencesEnd, vec3* outPositions, vec3* outNormals, vec4* outTangents, unsigned int begin, unsigned int end) {
+	bool hasTangents = tangents != 0 && outTangents != 0;
+	for (unsigned int i = begin; i < end; i++) {
+		// the unused influences of the groups have weight 0
+		int count = i < oneInfluenceEnd ? 1 : i < twoInfluencesEnd ? 2 : 4;
+		mat4 skin = dualQuatToMat4(blendDualQuaternions(palette, influences[i], weights[i], count));
+		outPositions[i] = transformPoint(skin, positions[i]);
+		outNormals[i] = normalized(transformVector(skin, normals[i]));
+		if (hasTangents) {
+			const vec4& tangent = tangents[i];
+			vec3 skinned = normalized(transformVector(skin, vec3(tangent.x, tangent.y, tangent.z)));
+			outTangents[i] = vec4(skinned.x, skinned.y, skinned.z, tangent.w);
+		}
+	}
+}
+
+void printDualQuaternionSkinningCheck(Skeleton& skeleton, const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec4>& weights, const std::vector<ivec4>& influences) {
+	unsigned int numVerts = (unsigned int)positions.size();
+	if (numVerts == 0 || normals.size() != numVerts || weights.size() != numVerts || influences.size() != numVerts) {
+		std::cout << "Dual quaternion skinning check: the mesh has no skinned vertices\n";
+		return;
+	}
+
+	// rigid motions of the whole skeleton: its root joints are moved, the rest keep their local transforms
+	Transform motions[3];
+	motions[1].rotation = angleAxis(0.5f, vec3(0, 1, 0));
+	motions[2].rotation = angleAxis(2.5f, normalized(vec3(1, 2, 3)));
+	motions[2].position = vec3(0.3f, -0.2f, 0.5f);
+
+	std::vector<mat4> palette;
+	std::vector<dualquat> dqPalette;
+	std::vector<vec3> dqPositions(numVerts);
+	std::vector<vec3> dqNormals(numVerts);
+	std::cout << "Dual quaternion skinning against the blended skin matrices, " << numVerts << " vertices:\n";
+	for (unsigned int m = 0; m < 3; ++m) {
+		Pose pose = skeleton.getBindPose();
+		for (unsigned int j = 0, size = pose.size(); j < size; ++j) {
+			if (pose.getParent(j) < 0) {
+				pose.setLocalTransform(j, combine(motions[m], pose.getLocalTransform(j)));
+			}
+		}
+		skeleton.getSkinPalette(pose, palette);
+		skeleton.getDualQuaternionPalette(pose, dqPalette);
+		// every vertex blends its 4 influences, the unused ones have weight 0
+		skinDualQuaternions(&dqPalette[0], &positions[0], &normals[0], 0, &weights[0], &influences[0], 0, 0, &dqPositions[0], &dqNormals[0], 0, 0, numVerts);
+
+		float positionError = 0.0f;
+		float normalError = 0.0f;
+		for (unsigned int i = 0; i < numVerts; ++i) {
+			const ivec4& joints = influences[i];
+			const vec4& w = weights[i];
+			if (w.x + w.y + w.z + w.w < 0.5f) {
+				continue; // without weight the skin matrix is 0, and the dual quaternion the identity
+			}
+			mat4 skin = palette[joints.x] * w.x + palette[joints.y] * w.y + palette[joints.z] * w.z + palette[joints.w] * w.w;
+			vec3 position = transformPoint(skin, positions[i]);
+			vec3 normal = normalized(transformVector(skin, normals[i]));
+			positionError = fmaxf(positionError, sqrtf(lenSq(position - dqPositions[i])));
+			normalError = fmaxf(normalError, sqrtf(lenSq(normal - dqNormals[i])));
+		}
+		std::cout << "  pose " << m << ": max position error " << positionError << ", max normal error " << normalError << "\n";
+	}
+}
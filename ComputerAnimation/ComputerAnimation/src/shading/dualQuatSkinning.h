@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "../math/vec3.h"
+#include "../math/vec4.h"
+#include "../math/dualquat.h"
+#include "../animation/skeleton.h"
+
+// Dual quaternion of a vertex: the palette dual quaternions of its first count influences (1 to 4) blended with their
+// weights and normalized. q and -q are the same transform, so the influences in the opposite hemisphere of the first one
+// are subtracted, otherwise the blend would take the long way around. A vertex without weight gets the identity
+dualquat blendDualQuaternions(const dualquat* palette, const ivec4& joints, const vec4& weights, int count);
+
+// Skins the vertices [begin, end) with a palette of Skeleton::getDualQuaternionPalette: the blend of each vertex is
+// converted to a rigid matrix, which transforms the position, the normal and the tangent. The vertices are grouped by
+// influence count (Mesh::sortByInfluenceCount): [0, oneInfluenceEnd) blend 1 influence, [oneInfluenceEnd, twoInfluencesEnd)
+// 2 and the rest 4. tangents and outTangents can be null
+void skinDualQuaternions(const dualquat* palette, const vec3* positions, const vec3* normals, const vec4* tangents, const vec4* weights, const ivec4* influences,
+	unsigned int oneInfluenceEnd, unsigned int twoInfluencesEnd, vec3* outPositions, vec3* outNormals, vec4* outTangents, unsigned int begin, unsigned int end);
+
+// Skins the vertices with the dual quaternions and with the blended skin matrices of the same poses, and prints the largest
+// difference of the positions and of the normals. The poses are rigid (the bind pose, and the bind pose moved and rotated
+// as a whole), where both skinnings must give the same vertices. Doesn't need an OpenGL context
+void printDualQuaternionSkinningCheck(Skeleton& skeleton, const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec4>& weights, const std::vector<ivec4>& influences);
@@ -1,5 +1,51 @@
 #include "mesh.h"
 #include "draw.h"
+#include "cacheCounters.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace MeshHelpers {
+
+	// skin matrix of a vertex: the palette matrices of its first N joints blended with their weights
+	template <unsigned int N>
+	inline void blend(const std::vector<mat4>& palette, const ivec4& joints, const vec4& weight, mat4& out) {
+		const float* m0 = palette[joints.x].v;
+		if (N == 1) {
+			for (int k = 0; k < 16; ++k) {
+				out.v[k] = m0[k] * weight.x;
+			}
+			return;
+		}
+		const float* m1 = palette[joints.y].v;
+		if (N == 2) {
+			for (int k = 0; k < 16; ++k) {
+				out.v[k] = m0[k] * weight.x + m1[k] * weight.y;
+			}
+			return;
+		}
+		const float* m2 = palette[joints.z].v;
+		const float* m3 = palette[joints.w].v;
+		for (int k = 0; k < 16; ++k) {
+			out.v[k] = m0[k] * weight.x + m1[k] * weight.y + m2[k] * weight.z + m3[k] * weight.w;
+		}
+	}
+
+	// values[i] = old values[order[i]], if there is a value per vertex
+	template <typename T>
+	inline void reorder(std::vector<T>& values, const std::vector<unsigned int>& order) {
+		if (values.size() != order.size()) {
+			return;
+		}
+		std::vector<T> sorted(values.size());
+		for (unsigned int i = 0, size = (unsigned int)order.size(); i < size; ++i) {
+			sorted[i] = values[order[i]];
+		}
+		values.swap(sorted);
+	}
+
+}; // End Mesh helpers namespace
 
 Mesh::Mesh() {
 	// allocate memory
@@ -15,6 +61,13 @@ Mesh::Mesh() {
 
 	morphTargetsAtlas = new DataTexture();
 	morphTargetsCount = new int();
+
+	skinStreamsDirty = true;
+	simdSkinning = true;
+	nonUniformScale = false;
+	oneInfluenceEnd = 0;
+	twoInfluencesEnd = 0;
+	rigidJoint = -1;
 }
 
 // copy constructor
@@ -31,6 +84,7 @@ Mesh::Mesh(const Mesh& m) {
 
 	morphTargetsAtlas = new DataTexture();
 	morphTargetsCount = new int();
+	nonUniformScale = false;
 	*this = m;
 }
 
@@ -42,6 +96,7 @@ Mesh& Mesh::operator=(const Mesh& other) {
 	// copy out the CPU values
 	positions = other.positions;
 	normals = other.normals;
+	tangents = other.tangents;
 	texCoords = other.texCoords;
 	weights = other.weights;
 	influences = other.influences;
@@ -50,6 +105,11 @@ Mesh& Mesh::operator=(const Mesh& other) {
 	morphTargets = other.morphTargets;
 	material = other.material;
 	name = other.name;
+	skinStreamsDirty = true;
+	simdSkinning = other.simdSkinning;
+	oneInfluenceEnd = other.oneInfluenceEnd;
+	twoInfluencesEnd = other.twoInfluencesEnd;
+	rigidJoint = other.rigidJoint;
 	// upload the attribute data to the GPU
 	updateOpenGLBuffers();
 	return *this;
@@ -77,6 +137,10 @@ std::vector<vec3>& Mesh::getNormals() {
 	return normals;
 }
 
+std::vector<vec4>& Mesh::getTangents() {
+	return tangents;
+}
+
 std::vector<vec2>& Mesh::getTexCoords() {
 	return texCoords;
 }
@@ -112,6 +176,7 @@ Material& Mesh::getMaterial() {
 // setters
 void Mesh::setPositions(std::vector<vec3> pos) {
 	positions = pos;
+	skinStreamsDirty = true;
 }
 
 void Mesh::setMaterial(Material mat) {
@@ -158,6 +223,30 @@ void Mesh::encodeMorphTargets() {
 
 // CPU skinning using matrices
 void Mesh::CPUSkin(Skeleton& skeleton, Pose& pose) {
+	// get the skin matrix of every joint: the global matrix of the joint in the current pose by its inverse bind pose
+	skeleton.getSkinPalette(pose, skinPalette);
+	CPUSkin(skinPalette);
+}
+
+void Mesh::CPUSkin(std::vector<mat4>& palette) {
+	if (positions.size() == 0) { return; }
+	skinVertices(palette);
+
+	// update the GPU position and normal attributes with the skinned positions and normals of all vertices
+	posAttrib->Set(skinnedPositions);
+	normAttrib->Set(skinnedNormals);
+}
+
+void Mesh::CPUSkin(std::vector<mat4>& palette, WorkerPool& pool) {
+	if (positions.size() == 0) { return; }
+	skinVertices(palette, &pool);
+
+	// the GPU buffers are updated by the calling thread, which owns the OpenGL context
+	posAttrib->Set(skinnedPositions);
+	normAttrib->Set(skinnedNormals);
+}
+
+void Mesh::skinVertices(std::vector<mat4>& palette, WorkerPool* pool) {
 
 	unsigned int numVerts = positions.size();
 	if (numVerts == 0) { return; }
@@ -165,56 +254,367 @@ void Mesh::CPUSkin(Skeleton& skeleton, Pose& pose) {
 	// Make sure the skinned vectors have enough storage space
 	skinnedPositions.resize(numVerts);
 	skinnedNormals.resize(numVerts);
+	skinnedTangents.resize(tangents.size() == numVerts ? numVerts : 0);
+	vec4* outTangents = skinnedTangents.empty() ? 0 : &skinnedTangents[0];
+
+	updateNormalPalette(palette);
+	mat4* normalMatrices = nonUniformScale ? &normalPalette[0] : 0;
+
+	bool avx2 = simdSkinning && cpuSupportsAVX2();
+	if (avx2 && (skinStreamsDirty || skinStreams.size != numVerts)) {
+		skinStreams.set(positions, normals, tangents, weights, influences);
+		skinStreams.oneInfluenceEnd = rigidJoint >= 0 ? numVerts : oneInfluenceEnd;
+		skinStreams.twoInfluencesEnd = rigidJoint >= 0 ? numVerts : twoInfluencesEnd;
+		skinStreamsDirty = false;
+	}
+
+	skinChunks(pool, [this, &palette, normalMatrices, outTangents, avx2](unsigned int begin, unsigned int end) {
+		if (avx2) {
+			skinStreamsAVX2(skinStreams, palette, normalMatrices, &skinnedPositions[0], &skinnedNormals[0], outTangents, begin, end);
+		}
+		else {
+			skinRange(palette, begin, end);
+		}
+	});
+}
+
+void Mesh::CPUSkin(std::vector<dualquat>& palette) {
+	if (positions.size() == 0) { return; }
+	skinVertices(palette);
+	posAttrib->Set(skinnedPositions);
+	normAttrib->Set(skinnedNormals);
+}
+
+void Mesh::CPUSkin(std::vector<dualquat>& palette, WorkerPool& pool) {
+	if (positions.size() == 0) { return; }
+	skinVertices(palette, &pool);
+	posAttrib->Set(skinnedPositions);
+	normAttrib->Set(skinnedNormals);
+}
+
+void Mesh::skinVertices(std::vector<dualquat>& palette, WorkerPool* pool) {
+	unsigned int numVerts = positions.size();
+	if (numVerts == 0) { return; }
+
+	skinnedPositions.resize(numVerts);
+	skinnedNormals.resize(numVerts);
+	skinnedTangents.resize(tangents.size() == numVerts ? numVerts : 0);
+	skinChunks(pool, [this, &palette](unsigned int begin, unsigned int end) {
+		skinRange(palette, begin, end);
+	});
+}
 
-	// get the global matrices from the current pose and set it to the corresponent array
-	poseMatrices = pose.getGlobalMatrices();
-	// get the inverse bind pose stored in the skeleton
-	std::vector<mat4> invBindPoseMat = skeleton.getInvBindPose();
+void Mesh::skinChunks(WorkerPool* pool, const std::function<void(unsigned int, unsigned int)>& skin) {
+	unsigned int numVerts = positions.size();
+	if (pool == 0 || pool->getNumThreads() == 1) {
+		skin(0, numVerts);
+		return;
+	}
 
-	for (unsigned int i = 0; i < numVerts; i++) //i = vertex
+	// About 4 chunks per thread to balance the load, of at least 1024 vertices so the cost of taking a chunk is small.
+	// The chunks are multiples of 16 vertices (192 bytes, 3 cache lines of the skinned vectors), and only the lines at
+	// their boundaries can be written by two threads
+	unsigned int chunkSize = numVerts / (pool->getNumThreads() * 4);
+	if (chunkSize < 1024) {
+		chunkSize = 1024;
+	}
+	chunkSize = (chunkSize + 15) & ~15u;
+	unsigned int numChunks = (numVerts + chunkSize - 1) / chunkSize;
+	pool->run(numChunks, [&skin, chunkSize, numVerts](unsigned int chunk) {
+		unsigned int begin = chunk * chunkSize;
+		unsigned int end = begin + chunkSize < numVerts ? begin + chunkSize : numVerts;
+		skin(begin, end);
+	});
+}
+
+// The normals are transformed by the inverse transpose of the skin matrix. Without non-uniform scale it is the skin matrix
+// itself (scaled, but the skinned normals are normalized), so it's only computed if some joint needs it
+void Mesh::updateNormalPalette(std::vector<mat4>& palette) {
+	unsigned int numJoints = (unsigned int)palette.size();
+	normalPalette.resize(numJoints);
+	nonUniformScale = false;
+	for (unsigned int j = 0; j < numJoints; ++j) {
+		mat4& m = palette[j];
+		vec3 x(m.v[0], m.v[1], m.v[2]);
+		vec3 y(m.v[4], m.v[5], m.v[6]);
+		vec3 z(m.v[8], m.v[9], m.v[10]);
+		// uniform scale: the axes have the same length and are perpendicular (the clips have scales 1e-4 off uniform)
+		float scaleSq = lenSq(x);
+		float tolerance = scaleSq * 0.001f;
+		bool uniform = fabsf(lenSq(y) - scaleSq) <= tolerance && fabsf(lenSq(z) - scaleSq) <= tolerance &&
+			fabsf(dot(x, y)) <= tolerance && fabsf(dot(x, z)) <= tolerance && fabsf(dot(y, z)) <= tolerance;
+		if (uniform) {
+			normalPalette[j] = m;
+		}
+		else {
+			normalPalette[j] = transposed(inverse(m));
+			nonUniformScale = true;
+		}
+	}
+}
+
+void Mesh::skinRange(std::vector<mat4>& palette, unsigned int begin, unsigned int end) {
+	bool hasTangents = !skinnedTangents.empty();
+	if (rigidJoint >= 0) {
+		// all the vertices are transformed by the matrix of the joint
+		mat4& skin = palette[rigidJoint];
+		mat4& normalMatrix = nonUniformScale ? normalPalette[rigidJoint] : skin;
+		for (unsigned int i = begin; i < end; i++) {
+			skinVertex(i, skin, normalMatrix, hasTangents);
+		}
+		return;
+	}
+	// the vertices with 1 and 2 influences are first (sortByInfluenceCount)
+	unsigned int oneEnd = std::min(std::max(oneInfluenceEnd, begin), end);
+	unsigned int twoEnd = std::min(std::max(twoInfluencesEnd, begin), end);
+	skinInfluences<1>(palette, begin, oneEnd, hasTangents);
+	skinInfluences<2>(palette, oneEnd, twoEnd, hasTangents);
+	skinInfluences<4>(palette, twoEnd, end, hasTangents);
+}
+
+template <unsigned int N>
+void Mesh::skinInfluences(std::vector<mat4>& palette, unsigned int begin, unsigned int end, bool hasTangents) {
+	for (unsigned int i = begin; i < end; i++) //i = vertex
 	{
 		ivec4& joints = influences[i];
 		vec4& weight = weights[i];
 
-		// TODO: Compute the skin matrix. For each vertex get the scaled skin matrix:
-		// 
-		// encontrar para cada joint de un vertex su matrix (4 matrices cada vertex)
-		// Get the matrix multiplying the transform of the joint pose (current/animated pose) by the inverse bind pose first (to get the vertex in the joint space)
+		// The final skin matrix is the blend of the palette matrices of the joints, scaled by their weights
+		mat4 finalSkinMatrix;
+		MeshHelpers::blend<N>(palette, joints, weight, finalSkinMatrix);
+
+		// The normals use the blend of the inverse transposes if some joint has non-uniform scale
+		if (nonUniformScale) {
+			mat4 normalMatrix;
+			MeshHelpers::blend<N>(normalPalette, joints, weight, normalMatrix);
+			skinVertex(i, finalSkinMatrix, normalMatrix, hasTangents);
+		}
+		else {
+			skinVertex(i, finalSkinMatrix, finalSkinMatrix, hasTangents);
+		}
+	}
+}
 
-		mat4 jointPoseTransform_x = poseMatrices[joints.x];
-		mat4 jointPoseTransform_y = poseMatrices[joints.y];
-		mat4 jointPoseTransform_z = poseMatrices[joints.z];
-		mat4 jointPoseTransform_w = poseMatrices[joints.w];
+// Dual quaternion linear blending (see skinDualQuaternions), a rigid mesh blends a single influence
+void Mesh::skinRange(std::vector<dualquat>& palette, unsigned int begin, unsigned int end) {
+	unsigned int oneEnd = rigidJoint >= 0 ? (unsigned int)positions.size() : oneInfluenceEnd;
+	bool hasTangents = !skinnedTangents.empty();
+	skinDualQuaternions(&palette[0], &positions[0], &normals[0], hasTangents ? &tangents[0] : 0, &weights[0], &influences[0], oneEnd, twoInfluencesEnd,
+		&skinnedPositions[0], &skinnedNormals[0], hasTangents ? &skinnedTangents[0] : 0, begin, end);
+}
 
-		mat4 invBindPose_x = invBindPoseMat[joints.x];
-		mat4 invBindPose_y = invBindPoseMat[joints.y];
-		mat4 invBindPose_z = invBindPoseMat[joints.z];
-		mat4 invBindPose_w = invBindPoseMat[joints.w];
+void Mesh::skinVertex(unsigned int i, const mat4& skin, const mat4& normalMatrix, bool hasTangents) {
+	// Get the skinned position of the vertex (object local space)
+	skinnedPositions[i] = transformPoint(skin, positions[i]);
 
-		mat4 jointSkinMatrix_x = jointPoseTransform_x * invBindPose_x;
-		mat4 jointSkinMatrix_y = jointPoseTransform_y * invBindPose_y;
-		mat4 jointSkinMatrix_z = jointPoseTransform_z * invBindPose_z;
-		mat4 jointSkinMatrix_w = jointPoseTransform_w * invBindPose_w;
+	// Get the skinned normal vector of the vertex (object local space) with the 3x3 of the normal matrix
+	skinnedNormals[i] = normalized(transformVector(normalMatrix, normals[i]));
 
-		// Scale the resulting matrices by their corresponding weight to get the final skin matrix
+	// The tangents are directions on the surface, transformed by the skin matrix
+	if (hasTangents) {
+		vec4& tangent = tangents[i];
+		vec3 skinned = normalized(transformVector(skin, vec3(tangent.x, tangent.y, tangent.z)));
+		skinnedTangents[i] = vec4(skinned.x, skinned.y, skinned.z, tangent.w);
+	}
+}
 
-		jointSkinMatrix_x = jointSkinMatrix_x * weight.x;
-		jointSkinMatrix_y = jointSkinMatrix_y * weight.y;
-		jointSkinMatrix_z = jointSkinMatrix_z * weight.z;
-		jointSkinMatrix_w = jointSkinMatrix_w * weight.w;
+// Sorts the vertices by their number of influences (1, 2, and 3 or 4), so that each group is skinned without blending the
+// matrices of the unused influences. The influences of each vertex are sorted by weight, and the indices and the morph
+// targets follow the new order of the vertices. Meshes without indices keep their order (only the rigid check is done)
+void Mesh::sortByInfluenceCount() {
+	oneInfluenceEnd = 0;
+	twoInfluencesEnd = 0;
+	rigidJoint = -1;
+	unsigned int numVerts = (unsigned int)positions.size();
+	if (numVerts == 0 || weights.size() != numVerts || influences.size() != numVerts) {
+		return;
+	}
 
-		mat4 finalSkinMatrix = jointSkinMatrix_x + jointSkinMatrix_y + jointSkinMatrix_z + jointSkinMatrix_w;
+	// group of each vertex: 0 for 1 influence, 1 for 2 influences, 2 for more
+	std::vector<unsigned int> groups(numVerts);
+	unsigned int groupSizes[3] = { 0, 0, 0 };
+	bool rigid = true;
+	for (unsigned int i = 0; i < numVerts; ++i) {
+		vec4& weight = weights[i];
+		ivec4& joints = influences[i];
+		// the largest weights first
+		for (int a = 1; a < 4; ++a) {
+			for (int b = a; b > 0 && weight.v[b] > weight.v[b - 1]; --b) {
+				std::swap(weight.v[b], weight.v[b - 1]);
+				std::swap(joints.v[b], joints.v[b - 1]);
+			}
+		}
+		unsigned int count = 0;
+		while (count < 4 && weight.v[count] > 0.0f) {
+			++count;
+		}
+		if (count == 1) {
+			// a single influence has all the weight (the weights of a vertex add up to 1)
+			weight.x = 1.0f;
+		}
+		rigid = rigid && count == 1 && joints.x == influences[0].x;
+		groups[i] = count <= 1 ? 0 : count == 2 ? 1 : 2;
+		groupSizes[groups[i]]++;
+	}
+	skinStreamsDirty = true;
 
-		// Get the skinned position of the vertex (object local space)
-		skinnedPositions[i] = transformPoint(finalSkinMatrix, positions[i]);
+	if (rigid) {
+		rigidJoint = influences[0].x;
+		return;
+	}
+	if (indices.empty()) {
+		return;
+	}
 
-		// Get the skinned normal vector of the vertex (object local space)
-		skinnedNormals[i] = transformVector(mat4ToTransform(finalSkinMatrix), normals[i]);
+	// new order of the vertices, keeping the order of the vertices of each group
+	std::vector<unsigned int> order(numVerts);
+	unsigned int next[3] = { 0, groupSizes[0], groupSizes[0] + groupSizes[1] };
+	for (unsigned int i = 0; i < numVerts; ++i) {
+		order[next[groups[i]]++] = i;
 	}
+	oneInfluenceEnd = groupSizes[0];
+	twoInfluencesEnd = groupSizes[0] + groupSizes[1];
+	reorderVertices(order);
+}
 
-	// update the GPU position and normal attributes with the skinned positions and normals of all vertices
-	posAttrib->Set(skinnedPositions);
-	normAttrib->Set(skinnedNormals);
+// Vertices that follow the same joints are skinned one after the other, so the palette matrices they read are still in
+// the L1 cache instead of jumping around the palette in the (arbitrary) order of the file. The groups of
+// sortByInfluenceCount keep their bounds
+void Mesh::sortByJoints() {
+	unsigned int numVerts = (unsigned int)positions.size();
+	if (numVerts == 0 || weights.size() != numVerts || influences.size() != numVerts || indices.empty() || isRigid()) {
+		return;
+	}
+
+	// key of each vertex: the joint with the largest weight, and then the other joints with weight in increasing order
+	// (-1 for the unused ones)
+	std::vector<ivec4> keys(numVerts);
+	for (unsigned int i = 0; i < numVerts; ++i) {
+		vec4& weight = weights[i];
+		ivec4& joints = influences[i];
+		int dominant = 0;
+		for (int j = 1; j < 4; ++j) {
+			if (weight.v[j] > weight.v[dominant]) {
+				dominant = j;
+			}
+		}
+		ivec4& key = keys[i];
+		key = ivec4(joints.v[dominant], -1, -1, -1);
+		int count = 1;
+		for (int j = 0; j < 4; ++j) {
+			if (j == dominant || weight.v[j] <= 0.0f) {
+				continue;
+			}
+			int b = count++;
+			key.v[b] = joints.v[j];
+			for (; b > 1 && key.v[b] < key.v[b - 1]; --b) {
+				std::swap(key.v[b], key.v[b - 1]);
+			}
+		}
+	}
+
+	std::vector<unsigned int> order(numVerts);
+	for (unsigned int i = 0; i < numVerts; ++i) {
+		order[i] = i;
+	}
+	unsigned int bounds[4] = { 0, std::min(oneInfluenceEnd, numVerts), std::min(twoInfluencesEnd, numVerts), numVerts };
+	for (int g = 0; g < 3; ++g) {
+		std::stable_sort(order.begin() + bounds[g], order.begin() + std::max(bounds[g], bounds[g + 1]),
+			[&keys](unsigned int a, unsigned int b) {
+				const ivec4& l = keys[a];
+				const ivec4& r = keys[b];
+				for (int j = 0; j < 4; ++j) {
+					if (l.v[j] != r.v[j]) {
+						return l.v[j] < r.v[j];
+					}
+				}
+				return false;
+			});
+	}
+	skinStreamsDirty = true;
+	reorderVertices(order);
+}
+
+void Mesh::reorderVertices(const std::vector<unsigned int>& order) {
+	std::vector<unsigned int> newIndex(order.size());
+	for (unsigned int i = 0, size = (unsigned int)order.size(); i < size; ++i) {
+		newIndex[order[i]] = i;
+	}
+	MeshHelpers::reorder(positions, order);
+	MeshHelpers::reorder(normals, order);
+	MeshHelpers::reorder(tangents, order);
+	MeshHelpers::reorder(texCoords, order);
+	MeshHelpers::reorder(weights, order);
+	MeshHelpers::reorder(influences, order);
+	for (unsigned int t = 0, size = (unsigned int)morphTargets.size(); t < size; ++t) {
+		MeshHelpers::reorder(morphTargets[t].vertexOffsets, order);
+		MeshHelpers::reorder(morphTargets[t].normals, order);
+	}
+	for (unsigned int i = 0, size = (unsigned int)indices.size(); i < size; ++i) {
+		indices[i] = newIndex[indices[i]];
+	}
+}
+
+bool Mesh::isRigid() {
+	return rigidJoint >= 0;
+}
+
+int Mesh::getRigidJoint() {
+	return rigidJoint;
+}
+
+std::vector<vec3>& Mesh::getSkinnedPositions() {
+	return skinnedPositions;
+}
+
+std::vector<vec3>& Mesh::getSkinnedNormals() {
+	return skinnedNormals;
+}
+
+std::vector<vec4>& Mesh::getSkinnedTangents() {
+	return skinnedTangents;
+}
+
+void Mesh::setSIMDSkinningEnabled(bool enabled) {
+	simdSkinning = enabled;
+}
+
+bool Mesh::isSIMDSkinningEnabled() {
+	return simdSkinning;
+}
+
+void printSkinningBenchmark(std::vector<Mesh>& meshes, std::vector<mat4>& palette, unsigned int maxThreads, unsigned int iterations) {
+	unsigned int numVerts = 0;
+	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+		numVerts += (unsigned int)meshes[i].getPositions().size();
+	}
+	std::cout << "CPU skinning of " << numVerts << " vertices, " << iterations << " iterations\n";
+	if (numVerts == 0 || iterations == 0) {
+		return;
+	}
+
+	WorkerPool pool(1);
+	double serialRate = 0.0;
+	for (unsigned int numThreads = 1; numThreads <= maxThreads; ++numThreads) {
+		pool.setNumThreads(numThreads);
+		// warm up the threads and the caches
+		for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+			meshes[i].skinVertices(palette, &pool);
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int it = 0; it < iterations; ++it) {
+			for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+				meshes[i].skinVertices(palette, &pool);
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double rate = (double)numVerts * iterations / seconds;
+		if (numThreads == 1) {
+			serialRate = rate;
+		}
+		std::cout << "  " << numThreads << " threads: " << rate / 1000000.0 << " M vertices/s (x" << rate / serialRate << ")\n";
+	}
 }
 
 
@@ -302,4 +702,122 @@ void Mesh::unBind(int position, int normal, int uv, int weight, int influence) {
 	}
 }
 
+void printSIMDSkinningBenchmark(std::vector<Mesh>& meshes, std::vector<mat4>& palette, unsigned int iterations) {
+	if (!cpuSupportsAVX2()) {
+		std::cout << "AVX2 skinning benchmark: the CPU doesn't support AVX2, the meshes use the scalar skinning\n";
+		return;
+	}
+	unsigned int numVerts = 0;
+	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+		numVerts += (unsigned int)meshes[i].getPositions().size();
+	}
+	std::cout << "Scalar and AVX2 CPU skinning of " << numVerts << " vertices, " << iterations << " iterations\n";
+	if (numVerts == 0 || iterations == 0) {
+		return;
+	}
+
+	std::vector<bool> enabled(meshes.size());
+	std::vector<std::vector<vec3> > scalarPositions(meshes.size());
+	std::vector<std::vector<vec3> > scalarNormals(meshes.size());
+	double rates[2];
+	for (int simd = 0; simd < 2; ++simd) {
+		for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+			if (simd == 0) {
+				enabled[i] = meshes[i].isSIMDSkinningEnabled();
+			}
+			meshes[i].setSIMDSkinningEnabled(simd == 1);
+			// warm up the caches (and build the streams of the AVX2 kernel)
+			meshes[i].skinVertices(palette);
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int it = 0; it < iterations; ++it) {
+			for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+				meshes[i].skinVertices(palette);
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		rates[simd] = (double)numVerts * iterations / seconds;
+		if (simd == 0) {
+			for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+				scalarPositions[i] = meshes[i].getSkinnedPositions();
+				scalarNormals[i] = meshes[i].getSkinnedNormals();
+			}
+		}
+	}
+
+	float positionError = 0.0f;
+	float normalError = 0.0f;
+	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+		std::vector<vec3>& positions = meshes[i].getSkinnedPositions();
+		std::vector<vec3>& normals = meshes[i].getSkinnedNormals();
+		for (unsigned int v = 0, numPositions = (unsigned int)positions.size(); v < numPositions; ++v) {
+			vec3 d = positions[v] - scalarPositions[i][v];
+			positionError = fmaxf(positionError, fmaxf(fabsf(d.x), fmaxf(fabsf(d.y), fabsf(d.z))));
+			d = normals[v] - scalarNormals[i][v];
+			normalError = fmaxf(normalError, fmaxf(fabsf(d.x), fmaxf(fabsf(d.y), fabsf(d.z))));
+		}
+		meshes[i].setSIMDSkinningEnabled(enabled[i]);
+	}
+	std::cout << "  scalar: " << rates[0] / 1000000.0 << " M vertices/s\n";
+	std::cout << "  AVX2: " << rates[1] / 1000000.0 << " M vertices/s (x" << rates[1] / rates[0] << ")\n";
+	std::cout << "  max difference: position " << positionError << ", normal " << normalError << "\n";
+}
+
+void printVertexOrderBenchmark(std::vector<Mesh>& meshes, std::vector<mat4>& palette, unsigned int iterations) {
+	unsigned int numVerts = 0;
+	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+		numVerts += (unsigned int)meshes[i].getPositions().size();
+	}
+	std::cout << "CPU skinning of " << numVerts << " vertices in file order and sorted by joints, " << iterations << " iterations\n";
+	if (numVerts == 0 || iterations == 0) {
+		return;
+	}
+
+	std::vector<Mesh> sorted(meshes);
+	for (unsigned int i = 0, size = (unsigned int)sorted.size(); i < size; ++i) {
+		sorted[i].sortByJoints();
+	}
+	CacheCounters counters;
+	if (!counters.isAvailable()) {
+		std::cout << "  the hardware cache counters are not available, only the speed is measured\n";
+	}
 
+	std::vector<bool> enabled(meshes.size());
+	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+		enabled[i] = meshes[i].isSIMDSkinningEnabled();
+	}
+	const char* kernels[2] = { "scalar", "AVX2" };
+	const char* orders[2] = { "file order", "sorted by joints" };
+	double numSkinned = (double)numVerts * iterations;
+	for (int simd = 0; simd < 2 && (simd == 0 || cpuSupportsAVX2()); ++simd) {
+		for (int o = 0; o < 2; ++o) {
+			std::vector<Mesh>& set = o == 0 ? meshes : sorted;
+			for (unsigned int i = 0, size = (unsigned int)set.size(); i < size; ++i) {
+				set[i].setSIMDSkinningEnabled(simd == 1);
+				// warm up the caches (and build the streams of the AVX2 kernel)
+				set[i].skinVertices(palette);
+			}
+			counters.start();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (unsigned int it = 0; it < iterations; ++it) {
+				for (unsigned int i = 0, size = (unsigned int)set.size(); i < size; ++i) {
+					set[i].skinVertices(palette);
+				}
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			counters.stop();
+
+			std::cout << "  " << kernels[simd] << ", " << orders[o] << ": " << numSkinned / seconds / 1000000.0 << " M vertices/s";
+			if (counters.isAvailable(CacheCounters::L1D_READ_MISSES)) {
+				std::cout << ", " << counters.getCount(CacheCounters::L1D_READ_MISSES) / numSkinned << " L1D read misses/vertex";
+			}
+			if (counters.isAvailable(CacheCounters::LLC_MISSES)) {
+				std::cout << ", " << counters.getCount(CacheCounters::LLC_MISSES) / numSkinned << " LLC misses/vertex";
+			}
+			std::cout << "\n";
+		}
+	}
+	for (unsigned int i = 0, size = (unsigned int)meshes.size(); i < size; ++i) {
+		meshes[i].setSIMDSkinningEnabled(enabled[i]);
+	}
+}
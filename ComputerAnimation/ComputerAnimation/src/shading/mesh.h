@@ -4,11 +4,15 @@
 #include "../math/vec3.h"
 #include "../math/vec4.h"
 #include "../math/mat4.h"
+#include "../math/dualquat.h"
 #include "attribute.h"
 #include "indexBuffer.h"
 #include "../animation/skeleton.h"
 #include "../animation/pose.h"
 #include "texture.h"
+#include "workerPool.h"
+#include "simdSkinning.h"
+#include "dualQuatSkinning.h"
 
 struct MorphTarget {
 	std::vector<vec3> vertexOffsets;
@@ -38,6 +42,7 @@ class Mesh
 protected:
 	std::vector<vec3> positions;
 	std::vector<vec3> normals;
+	std::vector<vec4> tangents; // xyz tangent and w sign of the bitangent (glTF), optional
 	std::vector<vec2> texCoords;
 	// each vertex can be influenced at most by 4 bones (vec4)
 	std::vector<vec4> weights;
@@ -48,7 +53,18 @@ protected:
 	// for CPU skinning
 	std::vector<vec3> skinnedPositions;
 	std::vector<vec3> skinnedNormals;
-	std::vector<mat4> poseMatrices; // global matrices of the pose joints
+	std::vector<vec4> skinnedTangents;
+	std::vector<mat4> skinPalette; // skin matrices of the pose joints
+	std::vector<mat4> normalPalette; // inverse transposes of the skin matrices, only used if nonUniformScale
+	bool nonUniformScale; // some skin matrix of the palette has non-uniform scale (or shear)
+	// after sortByInfluenceCount, the vertices [0, oneInfluenceEnd) have 1 influence, [oneInfluenceEnd, twoInfluencesEnd)
+	// have 2 and the rest up to 4
+	unsigned int oneInfluenceEnd;
+	unsigned int twoInfluencesEnd;
+	int rigidJoint; // joint of all the vertices if the mesh is rigid, -1 otherwise
+	SkinningStreams skinStreams; // vertex data of the AVX2 kernel
+	bool skinStreamsDirty; // the streams are rebuilt from the vertex data before the next skinning
+	bool simdSkinning; // use the AVX2 kernel if the CPU supports it
 
 	// for render in the GPU
 	Attribute<vec3>* posAttrib;
@@ -64,6 +80,20 @@ protected:
 	DataTexture* morphTargetsAtlas;
 	Material material;
 
+	// checks the scale of each skin matrix, and fills normalPalette if some of them is not uniform
+	void updateNormalPalette(std::vector<mat4>& palette);
+	// calls skin(begin, end) for the whole mesh, or for chunks of vertices in the threads of the pool
+	void skinChunks(WorkerPool* pool, const std::function<void(unsigned int, unsigned int)>& skin);
+	// skins the vertices [begin, end) into skinnedPositions, skinnedNormals and skinnedTangents
+	void skinRange(std::vector<mat4>& palette, unsigned int begin, unsigned int end);
+	void skinRange(std::vector<dualquat>& palette, unsigned int begin, unsigned int end);
+	// skins vertices with N influences (1, 2 or 4)
+	template <unsigned int N>
+	void skinInfluences(std::vector<mat4>& palette, unsigned int begin, unsigned int end, bool hasTangents);
+	void skinVertex(unsigned int i, const mat4& skin, const mat4& normalMatrix, bool hasTangents);
+	// moves the vertex order[i] to i in all the per vertex data and the morph targets, and remaps the indices
+	void reorderVertices(const std::vector<unsigned int>& order);
+
 public:
 	Mesh();
 	Mesh(const Mesh&);
@@ -75,6 +105,7 @@ public:
 	// getters
 	std::vector<vec3>& getPositions();
 	std::vector<vec3>& getNormals();
+	std::vector<vec4>& getTangents();
 	std::vector<vec2>& getTexCoords();
 	std::vector<vec4>& getWeights();
 	std::vector<ivec4>& getInfluences();
@@ -90,6 +121,31 @@ public:
 	
 	// applies CPU mesh-skinning
 	void CPUSkin(Skeleton& skeleton, Pose& pose);
+	// applies CPU mesh-skinning with the skin palette of the pose (Skeleton::getSkinPalette), to skin several meshes with the same palette
+	void CPUSkin(std::vector<mat4>& palette);
+	// applies CPU mesh-skinning splitting the vertices in chunks skinned by the threads of the pool
+	void CPUSkin(std::vector<mat4>& palette, WorkerPool& pool);
+	// skins the vertices without updating the GPU attributes (serially if there is no pool)
+	void skinVertices(std::vector<mat4>& palette, WorkerPool* pool = 0);
+	// dual quaternion skinning with the palette of Skeleton::getDualQuaternionPalette: the transforms of the joints are
+	// blended as dual quaternions, which keeps the volume of the twisted and bent joints (no candy-wrapper). Always scalar
+	void CPUSkin(std::vector<dualquat>& palette);
+	void CPUSkin(std::vector<dualquat>& palette, WorkerPool& pool);
+	void skinVertices(std::vector<dualquat>& palette, WorkerPool* pool = 0);
+	std::vector<vec3>& getSkinnedPositions();
+	std::vector<vec3>& getSkinnedNormals();
+	std::vector<vec4>& getSkinnedTangents();
+	// the AVX2 kernel is used by default when the CPU supports it, otherwise the vertices are skinned one at a time
+	void setSIMDSkinningEnabled(bool enabled);
+	bool isSIMDSkinningEnabled();
+	// groups the vertices by number of influences for the CPU skinning, and flags the mesh as rigid if all the vertices
+	// follow the same joint (called by loadMeshes)
+	void sortByInfluenceCount();
+	// optional: sorts the vertices of each influence group by dominant joint and then by the rest of their joints, so that
+	// the CPU skinning reads the palette matrices in order. The triangles keep their order
+	void sortByJoints();
+	bool isRigid();
+	int getRigidJoint();
 	// syncs the vectors holding data to the GPU
 	void updateOpenGLBuffers();
 	void encodeMorphTargets();
@@ -99,3 +155,11 @@ public:
 	void unBind(int position, int normal, int uv, int weight, int influence); // the parameters are the slots 
 
 };
+
+// skins the meshes with 1 to maxThreads threads and prints the vertices skinned per second of each thread count
+void printSkinningBenchmark(std::vector<Mesh>& meshes, std::vector<mat4>& palette, unsigned int maxThreads = 8, unsigned int iterations = 100);
+// skins the meshes on one thread with the scalar and the AVX2 kernels, and prints their speed and their largest difference
+void printSIMDSkinningBenchmark(std::vector<Mesh>& meshes, std::vector<mat4>& palette, unsigned int iterations = 100);
+// skins the meshes as they are and sorted by joints (sortByJoints on a copy), and prints the speed and the data cache misses
+// (hardware counters, Linux only) of each order with the scalar and the AVX2 kernels
+void printVertexOrderBenchmark(std::vector<Mesh>& meshes, std::vector<mat4>& palette, unsigned int iterations = 100);
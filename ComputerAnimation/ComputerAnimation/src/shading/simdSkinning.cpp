@@ -0,0 +1,213 @@
+#include "simdSkinning.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+// MSVC compiles the AVX2 intrinsics in any function, gcc and clang only in the functions built for AVX2 (the rest of
+// the file keeps the base instruction set, so it runs on any CPU)
+#ifdef _MSC_VER
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+void SkinningStreams::set(const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec4>& tangents, const std::vector<vec4>& weights, const std::vector<ivec4>& influences) {
+	size = (unsigned int)positions.size();
+	stride = (size + 7) & ~7u;
+	values.assign(NUM_STREAMS * stride, 0.0f);
+	joints.assign(4 * stride, 0);
+
+	float* v = values.empty() ? 0 : &values[0];
+	for (unsigned int i = 0; i < size; ++i) {
+		v[POSITION_X * stride + i] = positions[i].x;
+		v[POSITION_Y * stride + i] = positions[i].y;
+		v[POSITION_Z * stride + i] = positions[i].z;
+		if (i < normals.size()) {
+			v[NORMAL_X * stride + i] = normals[i].x;
+			v[NORMAL_Y * stride + i] = normals[i].y;
+			v[NORMAL_Z * stride + i] = normals[i].z;
+		}
+		if (i < tangents.size()) {
+			v[TANGENT_X * stride + i] = tangents[i].x;
+			v[TANGENT_Y * stride + i] = tangents[i].y;
+			v[TANGENT_Z * stride + i] = tangents[i].z;
+			v[TANGENT_W * stride + i] = tangents[i].w;
+		}
+		if (i < weights.size()) {
+			v[WEIGHT_0 * stride + i] = weights[i].x;
+			v[WEIGHT_1 * stride + i] = weights[i].y;
+			v[WEIGHT_2 * stride + i] = weights[i].z;
+			v[WEIGHT_3 * stride + i] = weights[i].w;
+		}
+		if (i < influences.size()) {
+			joints[i] = influences[i].x;
+			joints[stride + i] = influences[i].y;
+			joints[2 * stride + i] = influences[i].z;
+			joints[3 * stride + i] = influences[i].w;
+		}
+	}
+}
+
+// CPUID and XGETBV of MSVC, gcc and clang
+namespace CPUHelpers {
+
+	inline void cpuid(int* info, int leaf, int subleaf) {
+#ifdef _MSC_VER
+		__cpuidex(info, leaf, subleaf);
+#else
+		unsigned int eax, ebx, ecx, edx;
+		__cpuid_count(leaf, subleaf, eax, ebx, ecx, edx);
+		info[0] = (int)eax;
+		info[1] = (int)ebx;
+		info[2] = (int)ecx;
+		info[3] = (int)edx;
+#endif
+	}
+
+	// only valid if CPUID reports OSXSAVE
+	inline unsigned long long xgetbv(unsigned int index) {
+#ifdef _MSC_VER
+		return _xgetbv(index);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index)); // _xgetbv needs -mxsave in gcc
+		return ((unsigned long long)edx << 32) | eax;
+#endif
+	}
+}; // End CPU helpers namespace
+
+bool cpuSupportsAVX2() {
+	static int supported = -1;
+	if (supported < 0) {
+		int info[4];
+		CPUHelpers::cpuid(info, 0, 0);
+		int maxLeaf = info[0];
+		supported = 0;
+		if (maxLeaf >= 7) {
+			CPUHelpers::cpuid(info, 1, 0);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			// the OS saves the YMM registers on context switches
+			bool ymmEnabled = osxsave && (CPUHelpers::xgetbv(0) & 6) == 6;
+			CPUHelpers::cpuid(info, 7, 0);
+			bool avx2 = (info[1] & (1 << 5)) != 0;
+			supported = avx && ymmEnabled && avx2 ? 1 : 0;
+		}
+	}
+	return supported == 1;
+}
+
+// AVX2 helpers: one register holds a component of 8 vertices, the operations are the same as the scalar ones
+namespace SkinningHelpers {
+
+	AVX2_FUNCTION inline __m256 dot(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+	}
+
+	// like normalized(): vectors with a squared length below VEC3_EPSILON are not changed
+	AVX2_FUNCTION inline void normalize(__m256& x, __m256& y, __m256& z) {
+		__m256 lenSq = dot(x, y, z, x, y, z);
+		__m256 invLen = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lenSq));
+		invLen = _mm256_blendv_ps(invLen, _mm256_set1_ps(1.0f), _mm256_cmp_ps(lenSq, _mm256_set1_ps(VEC3_EPSILON), _CMP_LT_OQ));
+		x = _mm256_mul_ps(x, invLen);
+		y = _mm256_mul_ps(y, invLen);
+		z = _mm256_mul_ps(z, invLen);
+	}
+
+	// transformVector with the 3x3 of a matrix m[column * 3 + row]
+	AVX2_FUNCTION inline void transformVector(const __m256* m, __m256 x, __m256 y, __m256 z, __m256& outX, __m256& outY, __m256& outZ) {
+		outX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0], x), _mm256_mul_ps(m[3], y)), _mm256_mul_ps(m[6], z));
+		outY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[1], x), _mm256_mul_ps(m[4], y)), _mm256_mul_ps(m[7], z));
+		outZ = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[2], x), _mm256_mul_ps(m[5], y)), _mm256_mul_ps(m[8], z));
+	}
+
+	// blends the first rows of the first columns of the matrices of the first influences, m[column * 3 + row]
+	AVX2_FUNCTION inline void blend(const SkinningStreams& streams, const float* matrices, unsigned int i, unsigned int numInfluences, int columns, __m256* m) {
+		for (int k = 0; k < columns * 3; ++k) {
+			m[k] = _mm256_setzero_ps();
+		}
+		for (unsigned int j = 0; j < numInfluences; ++j) {
+			__m256i offsets = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)(streams.getJoints(j) + i)), 4);
+			__m256 weight = _mm256_loadu_ps(streams.getStream((SkinningStreams::Stream)(SkinningStreams::WEIGHT_0 + j)) + i);
+			for (int c = 0; c < columns; ++c) {
+				for (int r = 0; r < 3; ++r) {
+					__m256 value = _mm256_i32gather_ps(matrices + c * 4 + r, offsets, 4);
+					m[c * 3 + r] = _mm256_add_ps(m[c * 3 + r], _mm256_mul_ps(value, weight));
+				}
+			}
+		}
+	}
+
+}; // End Skinning helpers namespace
+
+AVX2_FUNCTION void skinStreamsAVX2(const SkinningStreams& streams, std::vector<mat4>& palette, const mat4* normalPalette, vec3* outPositions, vec3* outNormals, vec4* outTangents, unsigned int begin, unsigned int end) {
+	using namespace SkinningHelpers;
+	const float* px = streams.getStream(SkinningStreams::POSITION_X);
+	const float* py = streams.getStream(SkinningStreams::POSITION_Y);
+	const float* pz = streams.getStream(SkinningStreams::POSITION_Z);
+	const float* nx = streams.getStream(SkinningStreams::NORMAL_X);
+	const float* ny = streams.getStream(SkinningStreams::NORMAL_Y);
+	const float* nz = streams.getStream(SkinningStreams::NORMAL_Z);
+	const float* tx = streams.getStream(SkinningStreams::TANGENT_X);
+	const float* ty = streams.getStream(SkinningStreams::TANGENT_Y);
+	const float* tz = streams.getStream(SkinningStreams::TANGENT_Z);
+	const float* tw = streams.getStream(SkinningStreams::TANGENT_W);
+
+	for (unsigned int i = begin; i < end; i += 8) {
+		// the vertices are sorted by influence count, so the last one of the 8 has the most
+		unsigned int last = i + 7 < streams.size ? i + 7 : streams.size - 1;
+		unsigned int numInfluences = last < streams.oneInfluenceEnd ? 1 : last < streams.twoInfluencesEnd ? 2 : 4;
+
+		// blended skin matrix of the 8 vertices (the last row is not needed)
+		__m256 m[12];
+		blend(streams, palette[0].v, i, numInfluences, 4, m);
+
+		// transformPoint(m, position)
+		__m256 outX, outY, outZ;
+		transformVector(m, _mm256_loadu_ps(px + i), _mm256_loadu_ps(py + i), _mm256_loadu_ps(pz + i), outX, outY, outZ);
+		outX = _mm256_add_ps(outX, m[9]);
+		outY = _mm256_add_ps(outY, m[10]);
+		outZ = _mm256_add_ps(outZ, m[11]);
+
+		// normals by the 3x3 of the skin matrix, or by the blended inverse transposes
+		__m256 normalX, normalY, normalZ;
+		if (normalPalette != 0) {
+			__m256 n[9];
+			blend(streams, normalPalette[0].v, i, numInfluences, 3, n);
+			transformVector(n, _mm256_loadu_ps(nx + i), _mm256_loadu_ps(ny + i), _mm256_loadu_ps(nz + i), normalX, normalY, normalZ);
+		}
+		else {
+			transformVector(m, _mm256_loadu_ps(nx + i), _mm256_loadu_ps(ny + i), _mm256_loadu_ps(nz + i), normalX, normalY, normalZ);
+		}
+		normalize(normalX, normalY, normalZ);
+
+		// back to the arrays of the mesh
+		float out[9][8];
+		_mm256_storeu_ps(out[0], outX);
+		_mm256_storeu_ps(out[1], outY);
+		_mm256_storeu_ps(out[2], outZ);
+		_mm256_storeu_ps(out[3], normalX);
+		_mm256_storeu_ps(out[4], normalY);
+		_mm256_storeu_ps(out[5], normalZ);
+		unsigned int count = end - i < 8 ? end - i : 8;
+		for (unsigned int k = 0; k < count; ++k) {
+			outPositions[i + k] = vec3(out[0][k], out[1][k], out[2][k]);
+			outNormals[i + k] = vec3(out[3][k], out[4][k], out[5][k]);
+		}
+
+		if (outTangents != 0) {
+			__m256 tangentX, tangentY, tangentZ;
+			transformVector(m, _mm256_loadu_ps(tx + i), _mm256_loadu_ps(ty + i), _mm256_loadu_ps(tz + i), tangentX, tangentY, tangentZ);
+			normalize(tangentX, tangentY, tangentZ);
+			_mm256_storeu_ps(out[6], tangentX);
+			_mm256_storeu_ps(out[7], tangentY);
+			_mm256_storeu_ps(out[8], tangentZ);
+			for (unsigned int k = 0; k < count; ++k) {
+				outTangents[i + k] = vec4(out[6][k], out[7][k], out[8][k], tw[i + k]);
+			}
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include "../math/vec3.h"
+#include "../math/vec4.h"
+#include "../math/mat4.h"
+
+// Vertices of a mesh with every component in a separate array (structure of arrays), so that the AVX2 kernel loads the
+// same component of 8 vertices at once. The arrays are padded to a multiple of 8 vertices with weight 0 on joint 0.
+struct SkinningStreams {
+	enum Stream {
+		POSITION_X = 0, POSITION_Y, POSITION_Z,
+		NORMAL_X, NORMAL_Y, NORMAL_Z,
+		TANGENT_X, TANGENT_Y, TANGENT_Z, TANGENT_W,
+		WEIGHT_0, WEIGHT_1, WEIGHT_2, WEIGHT_3,
+		NUM_STREAMS
+	};
+
+	std::vector<float> values; // NUM_STREAMS arrays of stride values
+	std::vector<int> joints; // 4 arrays of stride joint ids, one per influence
+	unsigned int size; // vertices
+	unsigned int stride;
+	// groups of vertices by influence count (Mesh::sortByInfluenceCount): [0, oneInfluenceEnd) blend 1 matrix,
+	// [oneInfluenceEnd, twoInfluencesEnd) 2 and the rest 4
+	unsigned int oneInfluenceEnd;
+	unsigned int twoInfluencesEnd;
+
+	inline SkinningStreams() : size(0), stride(0), oneInfluenceEnd(0), twoInfluencesEnd(0) { }
+
+	void set(const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec4>& tangents, const std::vector<vec4>& weights, const std::vector<ivec4>& influences);
+	inline const float* getStream(Stream stream) const { return &values[stream * stride]; }
+	inline const int* getJoints(unsigned int influence) const { return &joints[influence * stride]; }
+};
+
+// true if the CPU and the OS support AVX2 (checked once with CPUID)
+bool cpuSupportsAVX2();
+
+// Skins the vertices [begin, end) of the streams, 8 at a time, with the same operations as the scalar Mesh::CPUSkin:
+// the palette matrices of the influences of their group are gathered and blended with the weights, the normals are transformed by the blended 3x3 (or by
+// the blended normalPalette if it's not null) and the tangents by the blended 3x3. outTangents can be null.
+// begin must be a multiple of 8. Only call it if cpuSupportsAVX2() is true
+void skinStreamsAVX2(const SkinningStreams& streams, std::vector<mat4>& palette, const mat4* normalPalette, vec3* outPositions, vec3* outNormals, vec4* outTangents, unsigned int begin, unsigned int end);
@@ -4,6 +4,8 @@
 #include "../math/vec4.h"
 #include "../math/quat.h"
 #include "../math/mat4.h"
+#include "../math/dualquat.h"
+#include "../math/mat3x4.h"
 #include <GL/glew.h>
 
 //supported uniform types
@@ -16,6 +18,8 @@ template Uniform<vec3>;
 template Uniform<vec4>;
 template Uniform<quat>;
 template Uniform<mat4>;
+template Uniform<dualquat>;
+template Uniform<mat3x4>;
 
 //set a single unifrom
 template <typename T>
@@ -50,4 +54,18 @@ template<> void Uniform<mat4>::Set(unsigned int slot,
 	mat4* inputArray, unsigned int arrayLength) {
 	glUniformMatrix4fv(slot, (GLsizei)arrayLength,
 		false, (float*)&inputArray[0]);
+}
+
+//dual quaternions are uploaded as mat2x4: the real part is the first column and the dual part the second one
+template<> void Uniform<dualquat>::Set(unsigned int slot,
+	dualquat* inputArray, unsigned int arrayLength) {
+	glUniformMatrix2x4fv(slot, (GLsizei)arrayLength,
+		false, (float*)&inputArray[0]);
+}
+
+//packed affine matrices are uploaded as mat3x4: each row of the matrix is a column of the GLSL matrix
+template<> void Uniform<mat3x4>::Set(unsigned int slot,
+	mat3x4* inputArray, unsigned int arrayLength) {
+	glUniformMatrix3x4fv(slot, (GLsizei)arrayLength,
+		false, (float*)&inputArray[0]);
 }
\ No newline at end of file
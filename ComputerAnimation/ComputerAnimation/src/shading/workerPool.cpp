@@ -0,0 +1,89 @@
+#include "workerPool.h"
+
+WorkerPool::WorkerPool(unsigned int numThreads) {
+	numTasks = 0;
+	nextTask = 0;
+	pendingWorkers = 0;
+	generation = 0;
+	stopping = false;
+	setNumThreads(numThreads);
+}
+
+WorkerPool::~WorkerPool() {
+	stop();
+}
+
+void WorkerPool::setNumThreads(unsigned int numThreads) {
+	stop();
+	if (numThreads == 0) {
+		numThreads = std::thread::hardware_concurrency();
+	}
+	stopping = false;
+	for (unsigned int i = 1; i < numThreads; ++i) {
+		workers.push_back(std::thread(&WorkerPool::workerLoop, this, generation));
+	}
+}
+
+unsigned int WorkerPool::getNumThreads() {
+	return (unsigned int)workers.size() + 1;
+}
+
+void WorkerPool::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+	for (unsigned int i = 0, size = (unsigned int)workers.size(); i < size; ++i) {
+		workers[i].join();
+	}
+	workers.clear();
+}
+
+void WorkerPool::run(unsigned int inNumTasks, const std::function<void(unsigned int)>& task) {
+	if (workers.empty() || inNumTasks <= 1) {
+		for (unsigned int i = 0; i < inNumTasks; ++i) {
+			task(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = task;
+		numTasks = inNumTasks;
+		nextTask = 0;
+		pendingWorkers = (unsigned int)workers.size();
+		++generation;
+	}
+	wakeUp.notify_all();
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return pendingWorkers == 0; });
+}
+
+void WorkerPool::runTasks() {
+	for (unsigned int i = nextTask++; i < numTasks; i = nextTask++) {
+		job(i);
+	}
+}
+
+void WorkerPool::workerLoop(unsigned int lastGeneration) {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this, lastGeneration] { return stopping || generation != lastGeneration; });
+			if (stopping) {
+				return;
+			}
+			lastGeneration = generation;
+		}
+		runTasks();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--pendingWorkers == 0) {
+				done.notify_one();
+			}
+		}
+	}
+}
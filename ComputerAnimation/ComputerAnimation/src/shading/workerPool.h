@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Threads that run the tasks of a job in parallel (used by the CPU skinning to split the vertices of the meshes).
+// The thread calling run works on the tasks as well, so a pool of N threads starts N - 1 workers.
+class WorkerPool {
+protected:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wakeUp; // a new job or the pool is stopping
+	std::condition_variable done; // the last worker finished the job
+	std::function<void(unsigned int)> job;
+	unsigned int numTasks;
+	std::atomic<unsigned int> nextTask;
+	unsigned int pendingWorkers; // workers that haven't finished the current job
+	unsigned int generation; // number of jobs run, the workers wait for the next one
+	bool stopping;
+
+protected:
+	// the workers start with the generation of the pool, so they don't miss a job run before they start
+	void workerLoop(unsigned int lastGeneration);
+	// takes the next task of the job until there are none left
+	void runTasks();
+	void stop();
+
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator=(const WorkerPool&);
+public:
+	// 0 threads uses a thread per core
+	WorkerPool(unsigned int numThreads = 0);
+	~WorkerPool();
+
+	// waits for the current workers and starts the new ones
+	void setNumThreads(unsigned int numThreads);
+	unsigned int getNumThreads();
+
+	// calls task(i) for every i in [0, numTasks) in the threads of the pool, and returns when all of them are done
+	void run(unsigned int numTasks, const std::function<void(unsigned int)>& task);
+};